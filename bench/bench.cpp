@@ -0,0 +1,417 @@
+#include "AutoPlayer.hpp"
+#include "BeamSearch.hpp"
+#include "Board.hpp"
+#include "Evaluator.hpp"
+#include "FeatureKernel.hpp"
+#include "MoveGenerator.hpp"
+#include "Piece.hpp"
+#include "Simulation.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Microbenchmarks for the board and piece hot paths. Each benchmark runs
+// in growing batches until a batch takes at least the minimum
+// time, then reports the time of one operation. The JSON output follows
+// the Google Benchmark layout so runs from two commits can be diffed with
+// its compare.py or any JSON tool.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // keeps the compiler from dropping a result nobody reads
+    template <typename T>
+    inline void keep(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct Result {
+        std::string name;
+        long long iterations;
+        double nsPerOp;
+    };
+
+    struct Fixture {
+        std::string name;
+        Board board;
+    };
+
+    // one legal resting position on a fixture
+    struct Placement {
+        Piece piece;
+        int x;
+        int y;
+    };
+
+    uint64_t splitmix64(uint64_t &x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    const char TYPES[TETROMINO_COUNT] = {'I', 'O', 'T', 'S', 'Z', 'J', 'L'};
+
+    std::vector<Fixture> makeFixtures() {
+        std::vector<Fixture> fixtures;
+
+        fixtures.push_back({"empty", Board()});
+
+        // bottom half stacked, one hole per row walking across the columns
+        Board halfFull;
+        for (int y = Board::HEIGHT / 2; y < Board::HEIGHT; ++y) {
+            int hole = (y * 3) % Board::WIDTH;
+            halfFull.setRow(y, Board::FULL_ROW & ~(1u << hole), TYPES[y % TETROMINO_COUNT]);
+        }
+        fixtures.push_back({"half-full", halfFull});
+
+        // four rows waiting for an I piece in the right-hand well
+        Board tetrisReady;
+        for (int y = Board::HEIGHT - 4; y < Board::HEIGHT; ++y) {
+            tetrisReady.setRow(y, Board::FULL_ROW & ~(1u << (Board::WIDTH - 1)), TYPES[y % TETROMINO_COUNT]);
+        }
+        fixtures.push_back({"tetris-ready", tetrisReady});
+
+        // twelve rows of garbage with one to three random holes each
+        Board garbage;
+        uint64_t state = 42;
+        for (int y = Board::HEIGHT - 12; y < Board::HEIGHT; ++y) {
+            uint16_t row = Board::FULL_ROW;
+            int holes = 1 + splitmix64(state) % 3;
+            for (int i = 0; i < holes; ++i) {
+                row &= ~(1u << (splitmix64(state) % Board::WIDTH));
+            }
+            garbage.setRow(y, row, 'G');
+        }
+        fixtures.push_back({"garbage", garbage});
+
+        return fixtures;
+    }
+
+    // every piece in every rotation, in a fixed order
+    std::vector<Piece> allRotations() {
+        std::vector<Piece> pieces;
+        for (int t = 0; t < TETROMINO_COUNT; ++t) {
+            Piece piece(static_cast<Piece::Tetromino>(t));
+            for (int r = 0; r < 4; ++r) {
+                pieces.push_back(piece);
+                piece.rotate();
+            }
+        }
+        return pieces;
+    }
+
+    // hard drop of every piece, rotation and column that fits from the top
+    std::vector<Placement> findPlacements(const Board &board, const std::vector<Piece> &pieces) {
+        std::vector<Placement> placements;
+        for (const Piece &piece : pieces) {
+            for (int x = -2; x < Board::WIDTH; ++x) {
+                if (board.isValidPosition(piece, x, 0)) {
+                    placements.push_back({piece, x, board.findDropPosition(piece, x, 0)});
+                }
+            }
+        }
+        return placements;
+    }
+
+    class Harness {
+        public:
+            Harness(double minSeconds, const std::string &filter)
+                : minSeconds(minSeconds), filter(filter) {}
+
+            // body runs `iterations` operations and is timed as one batch
+            void run(const std::string &name, const std::function<void(long long)> &body) {
+                if (!filter.empty() && name.find(filter) == std::string::npos)
+                    return;
+
+                body(1);
+                long long iterations = 1;
+                double seconds = 0.0;
+                while (true) {
+                    Clock::time_point start = Clock::now();
+                    body(iterations);
+                    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                    if (seconds >= minSeconds || iterations >= (1ll << 40))
+                        break;
+                    // aim just past the minimum instead of blindly doubling
+                    double scale = seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+                    if (scale > 10.0)
+                        scale = 10.0;
+                    if (scale < 2.0)
+                        scale = 2.0;
+                    iterations = static_cast<long long>(iterations * scale);
+                }
+                Result result = {name, iterations, seconds * 1e9 / iterations};
+                results.push_back(result);
+                std::fprintf(stderr, "%-48s %12.2f ns %14lld\n", name.c_str(), result.nsPerOp, iterations);
+            }
+
+            const std::vector<Result> &getResults() const { return results; }
+
+        private:
+            double minSeconds;
+            std::string filter;
+            std::vector<Result> results;
+    };
+
+    void writeJson(std::ostream &out, const std::vector<Result> &results) {
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        out << "{\n"
+            << "  \"context\": {\n"
+            << "    \"date\": \"" << date << "\",\n"
+            << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+            << "    \"library_build_type\": \"release\"\n"
+            << "  },\n"
+            << "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result &r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"run_type\": \"iteration\", \"iterations\": "
+                << r.iterations << ", \"real_time\": " << r.nsPerOp << ", \"cpu_time\": " << r.nsPerOp
+                << ", \"time_unit\": \"ns\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+    void usage(const char *name) {
+        std::cerr << "Usage: " << name << " [options]\n"
+                  << "  -t <seconds>     minimum time per benchmark (default 0.2)\n"
+                  << "  -f <filter>      only run benchmarks whose name contains filter\n"
+                  << "  -o <file>        write JSON results to file instead of stdout\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    double minSeconds = 0.2;
+    std::string filter;
+    std::string outputPath;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc || arg[0] != '-' || std::strlen(arg) != 2) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        switch (arg[1]) {
+            case 't': minSeconds = std::atof(value); break;
+            case 'f': filter = value; break;
+            case 'o': outputPath = value; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    Harness harness(minSeconds, filter);
+    std::vector<Fixture> fixtures = makeFixtures();
+    std::vector<Piece> pieces = allRotations();
+
+    for (const Fixture &fixture : fixtures) {
+        const Board &board = fixture.board;
+        std::vector<Placement> placements = findPlacements(board, pieces);
+
+        // a sweep over the whole board, mostly the cheap out-of-bounds and
+        // collision rejections a move generator sees
+        harness.run("Board/isValidPosition/" + fixture.name, [&](long long n) {
+            size_t p = 0;
+            int x = -2, y = 0;
+            for (long long i = 0; i < n; ++i) {
+                keep(board.isValidPosition(pieces[p], x, y));
+                if (++x == Board::WIDTH) {
+                    x = -2;
+                    if (++y == Board::HEIGHT) {
+                        y = 0;
+                        if (++p == pieces.size())
+                            p = 0;
+                    }
+                }
+            }
+        });
+
+        harness.run("Board/findDropPosition/" + fixture.name, [&](long long n) {
+            size_t p = 0;
+            for (long long i = 0; i < n; ++i) {
+                const Placement &placement = placements[p];
+                keep(board.findDropPosition(placement.piece, placement.x, 0));
+                if (++p == placements.size())
+                    p = 0;
+            }
+        });
+
+        // includes copying the fixture, the board being modified by each call
+        harness.run("Board/placePiece/" + fixture.name, [&](long long n) {
+            size_t p = 0;
+            for (long long i = 0; i < n; ++i) {
+                Board copy = board;
+                const Placement &placement = placements[p];
+                keep(copy.placePiece(placement.piece, placement.x, placement.y));
+                if (++p == placements.size())
+                    p = 0;
+            }
+        });
+
+        // same fixture with its one-cell holes plugged, so full rows exist
+        // wherever the fixture is one cell away from a clear
+        Board plugged = board;
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            uint16_t row = plugged.getRow(y);
+            uint16_t holes = Board::FULL_ROW & ~row;
+            if (row != 0 && (holes & (holes - 1)) == 0)
+                plugged.setRow(y, Board::FULL_ROW, 'I');
+        }
+        harness.run("Board/clearFullLines/" + fixture.name, [&](long long n) {
+            for (long long i = 0; i < n; ++i) {
+                Board copy = plugged;
+                keep(copy.clearFullLines());
+            }
+        });
+
+        Evaluator evaluator;
+        harness.run("Evaluator/evaluate/" + fixture.name, [&](long long n) {
+            for (long long i = 0; i < n; ++i)
+                keep(evaluator.evaluate(board, 0));
+        });
+
+        // every placement of one piece from the spawn, cycling through the
+        // seven tetrominoes
+        MoveGenerator generator;
+        std::vector<MoveGenerator::Placement> found(MoveGenerator::MAX_PLACEMENTS);
+        harness.run("MoveGenerator/generate/" + fixture.name, [&](long long n) {
+            int t = 0;
+            for (long long i = 0; i < n; ++i) {
+                Piece piece(static_cast<Piece::Tetromino>(t));
+                keep(generator.generate(board, piece, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                        found.data(), MoveGenerator::MAX_PLACEMENTS));
+                if (++t == TETROMINO_COUNT)
+                    t = 0;
+            }
+        });
+
+        // input path to each T placement in turn
+        Simulation::Action path[256];
+        int placementCount = generator.generate(board, Piece(Piece::T), Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                                found.data(), MoveGenerator::MAX_PLACEMENTS);
+        harness.run("MoveGenerator/getPath/" + fixture.name, [&](long long n) {
+            int p = 0;
+            for (long long i = 0; i < n; ++i) {
+                keep(generator.getPath(found[p], path, 256));
+                if (++p == placementCount)
+                    p = 0;
+            }
+        });
+    }
+
+    harness.run("Piece/construct", [&](long long n) {
+        int t = 0;
+        for (long long i = 0; i < n; ++i) {
+            Piece piece(static_cast<Piece::Tetromino>(t));
+            keep(piece);
+            if (++t == TETROMINO_COUNT)
+                t = 0;
+        }
+    });
+
+    harness.run("Piece/rotate", [&](long long n) {
+        Piece piece(Piece::T);
+        for (long long i = 0; i < n; ++i) {
+            piece.rotate();
+            keep(piece);
+        }
+    });
+
+    harness.run("Piece/getFootprint", [&](long long n) {
+        size_t p = 0;
+        for (long long i = 0; i < n; ++i) {
+            keep(pieces[p].getFootprint().rowMasks);
+            if (++p == pieces.size())
+                p = 0;
+        }
+    });
+
+    // features of 64 boards (the fixtures in turn) with every kernel the
+    // CPU supports, the size of a beam search expansion
+    {
+        std::vector<const Board *> batch;
+        for (int i = 0; i < 64; ++i)
+            batch.push_back(&fixtures[i % fixtures.size()].board);
+        std::vector<BoardFeatures> features(batch.size());
+        for (int isa = FeatureKernel::SCALAR; isa <= FeatureKernel::AVX2; ++isa) {
+            FeatureKernel::Isa kernel = static_cast<FeatureKernel::Isa>(isa);
+            if (!FeatureKernel::isSupported(kernel))
+                continue;
+            harness.run(std::string("FeatureKernel/batch64/") + FeatureKernel::getName(kernel), [&](long long n) {
+                for (long long i = 0; i < n; ++i) {
+                    FeatureKernel::compute(batch.data(), static_cast<int>(batch.size()), features.data(), kernel);
+                    keep(features[0]);
+                }
+            });
+        }
+    }
+
+    // one full decision: every placement of the current piece, each
+    // followed by every placement of the next one (player setup included)
+    harness.run("AutoPlayer/plan", [&](long long n) {
+        for (long long i = 0; i < n; ++i) {
+            Simulation simulation(static_cast<uint64_t>(i));
+            AutoPlayer player;
+            keep(player.chooseAction(simulation));
+        }
+    });
+
+    // the whole queue with hold at the default beam width, no deadline so
+    // every run searches the same depth; thread start-up is not counted
+    {
+        BeamSearch::Settings settings;
+        settings.deadlineMicros = 0;
+        BeamSearch planner(Evaluator(), settings);
+        BeamSearch::Plan plan;
+        harness.run("BeamSearch/plan", [&](long long n) {
+            for (long long i = 0; i < n; ++i) {
+                Simulation simulation(static_cast<uint64_t>(i));
+                keep(planner.plan(simulation, plan));
+            }
+        });
+    }
+
+    harness.run("Simulation/construct", [&](long long n) {
+        for (long long i = 0; i < n; ++i) {
+            Simulation simulation(static_cast<uint64_t>(i));
+            keep(simulation.getCurrentPiece());
+        }
+    });
+
+    // lock plus spawn of the next piece, the same path the game takes on
+    // a hard drop; the stack is reset whenever it tops out
+    harness.run("Simulation/hardDropAndSpawn", [&](long long n) {
+        Simulation simulation(1);
+        for (long long i = 0; i < n; ++i) {
+            if (simulation.isGameOver())
+                simulation = Simulation(static_cast<uint64_t>(i));
+            keep(simulation.step(Simulation::HARD_DROP));
+        }
+    });
+
+    if (outputPath.empty()) {
+        writeJson(std::cout, harness.getResults());
+    } else {
+        std::ofstream out(outputPath);
+        if (!out) {
+            std::cerr << "Cannot open " << outputPath << " for writing" << std::endl;
+            return 1;
+        }
+        writeJson(out, harness.getResults());
+        std::cerr << "Results written to " << outputPath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "AssetManager.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    template <typename T>
+    bool isReady(const std::future<T> &future) {
+        return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+}
+
+AssetManager::AssetManager() : start(std::chrono::steady_clock::now()), audio(nullptr), audioReady(false),
+             loading(LOADED_NONE), windowMillis(-1), firstFrameMillis(-1), fontMillis(-1), audioMillis(-1) {}
+
+AssetManager::~AssetManager() {
+    wait();
+}
+
+double AssetManager::elapsed() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AssetManager::load(const std::string &fontPath, AudioManager &audioManager) {
+    if (loading != LOADED_NONE)
+        return;
+    audio = &audioManager;
+    loading = LOADED_FONT | LOADED_AUDIO;
+
+    pendingFont = std::async(std::launch::async, [this, fontPath]() {
+        FontLoad result;
+        std::ifstream file(fontPath, std::ios::binary);
+        if (file)
+            result.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        else
+            std::cerr << "Failed to open font " << fontPath << std::endl;
+        result.millis = elapsed();
+        return result;
+    });
+    pendingAudio = std::async(std::launch::async, [this]() {
+        AudioLoad result;
+        result.ready = audio->init();
+        result.millis = elapsed();
+        return result;
+    });
+}
+
+int AssetManager::poll() {
+    int loaded = LOADED_NONE;
+    if (isReady(pendingFont)) {
+        FontLoad result = pendingFont.get();
+        fontData = std::move(result.data);
+        fontMillis = result.millis;
+        loaded |= LOADED_FONT;
+    }
+    if (isReady(pendingAudio)) {
+        AudioLoad result = pendingAudio.get();
+        audioReady = result.ready;
+        audioMillis = result.millis;
+        loaded |= LOADED_AUDIO;
+    }
+    loading &= ~loaded;
+    return loaded;
+}
+
+void AssetManager::wait() {
+    if (pendingFont.valid())
+        pendingFont.wait();
+    if (pendingAudio.valid())
+        pendingAudio.wait();
+}
+
+void AssetManager::markWindow() {
+    if (windowMillis < 0)
+        windowMillis = elapsed();
+}
+
+void AssetManager::markFirstFrame() {
+    if (firstFrameMillis < 0)
+        firstFrameMillis = elapsed();
+}
+
+bool AssetManager::isDone() const {
+    return loading == LOADED_NONE && firstFrameMillis >= 0;
+}
+
+void AssetManager::report(std::ostream &out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out.setf(std::ios::fixed);
+    out.precision(1);
+    out << "Startup: window " << windowMillis << " ms, menu on screen " << firstFrameMillis << " ms";
+    out << " | font " << fontMillis << " ms";
+    if (audio) {
+        AudioManager::LoadTimes times = audio->getLoadTimes();
+        out << ", audio " << audioMillis << " ms (device " << times.device << ", sounds " << times.sounds
+            << ", music " << times.music << ")";
+    }
+    out << " | everything in " << std::max({ firstFrameMillis, fontMillis, audioMillis }) << " ms" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,77 @@
+#ifndef _ASSET_MANAGER_
+    #define _ASSET_MANAGER_
+#include "AudioManager.hpp"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Startup loading off the main thread. load() reads the font file and
+// initializes the audio (device, sound effects and music, themselves side
+// by side) on worker threads while the window and renderer are created;
+// the main thread picks each result up with poll() as it comes in, so the
+// menu is drawn and takes input from the first frame. Every step is timed
+// from construction for the startup report.
+class AssetManager {
+    public:
+        // what poll() just handed over
+        enum Loaded {
+            LOADED_NONE = 0,
+            LOADED_FONT = 1 << 0,
+            LOADED_AUDIO = 1 << 1
+        };
+
+        AssetManager();
+        ~AssetManager();
+
+        AssetManager(const AssetManager &) = delete;
+        AssetManager &operator=(const AssetManager &) = delete;
+
+        void load(const std::string &fontPath, AudioManager &audio);
+        // main thread, once per frame: returns the Loaded flags of what
+        // finished since the last call
+        int poll();
+        // blocks until every load is over (before SDL_Quit)
+        void wait();
+        // the font file once LOADED_FONT was reported, empty if it could not be read
+        std::vector<uint8_t> takeFontData() { return std::move(fontData); }
+        bool isAudioReady() const { return audioReady; }
+
+        // main thread milestones, only the first call of each counts
+        void markWindow();
+        void markFirstFrame();
+        // loads over and the menu on screen
+        bool isDone() const;
+        void report(std::ostream &out) const;
+
+    private:
+        struct FontLoad {
+            std::vector<uint8_t> data;
+            double millis;
+        };
+
+        struct AudioLoad {
+            bool ready;
+            double millis;
+        };
+
+        std::chrono::steady_clock::time_point start;
+        AudioManager *audio;
+        std::future<FontLoad> pendingFont;
+        std::future<AudioLoad> pendingAudio;
+        std::vector<uint8_t> fontData;
+        bool audioReady;
+        int loading;
+
+        // since construction, negative until it happened
+        double windowMillis;
+        double firstFrameMillis;
+        double fontMillis;
+        double audioMillis;
+
+        double elapsed() const;
+};
+
+#endif /* _ASSET_MANAGER_ */
@@ -1,23 +1,89 @@
 #include "AudioManager.hpp"
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <string>
+#include <cstring>
 #include <unistd.h>
 #include <linux/limits.h>
 #include <algorithm> // std::max && std::min
 
-AudioManager::AudioManager() : backgroundMusic(nullptr), musicVolume(40), soundVolume(80) {
-    soundEffects.clear();
+static_assert(AudioManager::SOUND_COUNT <= SOUND_MIXER_VOICES, "one mixer voice per sound effect");
+
+namespace {
+    double millisSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // one WAV file converted to 16-bit stereo at the device rate, empty on failure
+    std::vector<int16_t> decodeSound(const std::string &path, const char *name, int frequency) {
+        std::vector<int16_t> decoded;
+        SDL_AudioSpec spec;
+        Uint8 *samples = nullptr;
+        Uint32 length = 0;
+        SDL_AudioCVT cvt;
+
+        if (!SDL_LoadWAV(path.c_str(), &spec, &samples, &length)) {
+            std::cerr << "Failed to load sound " << name << "! SDL Error: " << SDL_GetError() << std::endl;
+            return decoded;
+        }
+        int needed = SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, AUDIO_S16SYS, 2, frequency);
+        if (needed < 0) {
+            std::cerr << "Cannot convert sound " << name << "! SDL Error: " << SDL_GetError() << std::endl;
+            SDL_FreeWAV(samples);
+            return decoded;
+        }
+        std::vector<Uint8> converted(samples, samples + length);
+        converted.resize(static_cast<size_t>(length) * std::max(cvt.len_mult, 1));
+        SDL_FreeWAV(samples);
+        size_t convertedLength = length;
+        if (needed > 0) {
+            cvt.buf = converted.data();
+            cvt.len = static_cast<int>(length);
+            SDL_ConvertAudio(&cvt);
+            convertedLength = static_cast<size_t>(cvt.len_cvt);
+        }
+        // whole stereo frames of 2 x 16 bits
+        size_t frames = convertedLength / (2 * sizeof(int16_t));
+        decoded.resize(frames * 2);
+        std::memcpy(decoded.data(), converted.data(), frames * 2 * sizeof(int16_t));
+        return decoded;
+    }
 }
 
+AudioManager &AudioManager::getInstance() {
+    static AudioManager instance;
+    return instance;
+}
+
+AudioManager::AudioManager() : backgroundMusic(nullptr), musicVolume(40), soundVolume(80),
+             bufferFrames(AUDIO_BUFFER_FRAMES), frequency(AUDIO_FREQUENCY), initialized(false), ready(false),
+             loadTimes(), droppedSounds(0) {}
+
 AudioManager::~AudioManager() {
+    shutdown();
+}
+
+void AudioManager::shutdown() {
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (!initialized)
+        return;
     try {
-        for (auto &pair : soundEffects) {
-            if (pair.second) {
-                Mix_FreeChunk(pair.second);
-                pair.second = nullptr;
+        // no callback may run once the voices lose their samples
+        Mix_SetPostMix(nullptr, nullptr);
+        for (int effect = 0; effect < SOUND_COUNT; ++effect)
+            mixer.setSound(effect, nullptr, 0);
+        soundBank.clear();
+        soundBank.shrink_to_fit();
+
+        if (musicStream.isOpen()) {
+            musicStream.close();
+            MusicStream::Stats stats = musicStream.getStats();
+            if (stats.underruns > 0) {
+                std::cerr << "Warning: music ran dry " << stats.underruns << " times ("
+                          << stats.missingFrames << " frames of silence)" << std::endl;
             }
         }
-        soundEffects.clear();
         
         if (backgroundMusic) {
             Mix_FreeMusic(backgroundMusic);
@@ -33,9 +99,20 @@ AudioManager::~AudioManager() {
     } catch (...) {
         std::cerr << "Unknown exception during AudioManager cleanup" << std::endl;
     }
+    initialized = false;
+    ready = false;
+}
+
+void AudioManager::setBufferFrames(int frames) {
+    bufferFrames = std::max(64, frames);
 }
 
 bool AudioManager::init() {
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (initialized)
+        return ready;
+    initialized = true;
+    auto start = std::chrono::steady_clock::now();
     try {
         if (SDL_WasInit(SDL_INIT_AUDIO) == 0) {
             if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -50,13 +127,33 @@ bool AudioManager::init() {
             std::cerr << "Mix_Init: Failed to init required mp3 support! SDL_Mixer Error: " << Mix_GetError() << std::endl;
         }
         
-        if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+        // 16-bit stereo exactly (no allowed changes, SDL converts if it has
+        // to): that is what the sound bank and SoundMixer work in
+        if (Mix_OpenAudioDevice(AUDIO_FREQUENCY, AUDIO_S16SYS, 2, bufferFrames, nullptr, 0) < 0) {
             std::cerr << "SDL_Mixer could not initialize! SDL_Mixer Error: " << Mix_GetError() << std::endl;
             return false;
         }
         
-        bool soundsLoaded = loadSounds();
-        bool musicLoaded = loadMusic();
+        // decoded straight to what the device plays, so playing a sound
+        // is only adding samples
+        Uint16 format;
+        int channels;
+        bool formatOk = Mix_QuerySpec(&frequency, &format, &channels) && format == AUDIO_S16SYS && channels == 2;
+        if (!formatOk)
+            std::cerr << "Unexpected mixer format! SDL_Mixer Error: " << Mix_GetError() << std::endl;
+        loadTimes.device = millisSince(start);
+
+        // the music file and the sound effects load side by side
+        std::future<bool> music = std::async(std::launch::async, [this]() {
+            auto musicStart = std::chrono::steady_clock::now();
+            bool loaded = loadMusic();
+            loadTimes.music = millisSince(musicStart);
+            return loaded;
+        });
+        auto soundsStart = std::chrono::steady_clock::now();
+        bool soundsLoaded = formatOk && loadSounds();
+        loadTimes.sounds = millisSince(soundsStart);
+        bool musicLoaded = music.get();
         
         if (!soundsLoaded) {
             std::cerr << "Warning: Failed to load some sound effects!" << std::endl;
@@ -69,7 +166,9 @@ bool AudioManager::init() {
         setMusicVolume(musicVolume);
         setSoundVolume(soundVolume);
 
-        return soundsLoaded || musicLoaded;
+        ready = soundsLoaded || musicLoaded;
+        Mix_SetPostMix(&AudioManager::postMix, this);
+        return ready;
     } catch (const std::exception& e) {
         std::cerr << "Exception during audio initialization: " << e.what() << std::endl;
         return false;
@@ -79,16 +178,17 @@ bool AudioManager::init() {
     }
 }
 
+std::string AudioManager::getAssetPath(const char *filename) const {
+    char currentPath[PATH_MAX];
+    if (getcwd(currentPath, sizeof(currentPath)) == nullptr) {
+        std::cerr << "Failed to get current working directory" << std::endl;
+        return std::string();
+    }
+    return std::string(currentPath) + "/assets/sounds/" + filename;
+}
+
 bool AudioManager::loadSounds() {
     try {
-        char currentPath[PATH_MAX];
-        if (getcwd(currentPath, sizeof(currentPath)) == nullptr) {
-            std::cerr << "Failed to get current working directory" << std::endl;
-            return false;
-        }
-        
-        std::string basePath = std::string(currentPath) + "/assets/sounds/";
-        
         const struct {
             SoundEffect effect;
             const char* filename;
@@ -98,20 +198,35 @@ bool AudioManager::loadSounds() {
             { LINE_CLEAR, "line_cleared.wav" },
             { GAME_OVER, "game_over.wav" }
         };
-        
-        bool allSoundsLoaded = true;
-        
+
+        // every file is decoded on its own thread, then packed into the bank
+        std::array<std::future<std::vector<int16_t>>, SOUND_COUNT> decoding;
         for (const auto& soundFile : soundFiles) {
-            std::string fullPath = basePath + soundFile.filename;
-            
-            Mix_Chunk* sound = Mix_LoadWAV(fullPath.c_str());
-            if (!sound) {
-                std::cerr << "Failed to load sound " << soundFile.filename 
-                          << "! SDL_Mixer Error: " << Mix_GetError() << std::endl;
+            decoding[soundFile.effect] = std::async(std::launch::async, decodeSound,
+                                                    getAssetPath(soundFile.filename), soundFile.filename, frequency);
+        }
+
+        struct Slice {
+            size_t offset;
+            size_t frames;
+        };
+        std::array<Slice, SOUND_COUNT> slices = {};
+        bool allSoundsLoaded = true;
+
+        for (int effect = 0; effect < SOUND_COUNT; ++effect) {
+            std::vector<int16_t> samples = decoding[effect].get();
+            if (samples.empty()) {
                 allSoundsLoaded = false;
-            } else {
-                soundEffects[soundFile.effect] = sound;
+                continue;
             }
+            slices[effect] = { soundBank.size(), samples.size() / 2 };
+            soundBank.insert(soundBank.end(), samples.begin(), samples.end());
+        }
+
+        // the bank is complete and never grows again, the voices can point into it
+        for (int effect = 0; effect < SOUND_COUNT; ++effect) {
+            if (slices[effect].frames > 0)
+                mixer.setSound(effect, soundBank.data() + slices[effect].offset, slices[effect].frames);
         }
         
         return allSoundsLoaded;
@@ -126,14 +241,11 @@ bool AudioManager::loadSounds() {
 
 bool AudioManager::loadMusic() {
     try {
-        char currentPath[PATH_MAX];
-        if (getcwd(currentPath, sizeof(currentPath)) == nullptr) {
-            std::cerr << "Failed to get current working directory" << std::endl;
-            return false;
-        }
-        
-        std::string basePath = std::string(currentPath) + "/assets/sounds/";
-        std::string musicPath = basePath + "background_music.mp3";
+        // a WAV playlist is streamed, MP3 (or no playlist) goes to SDL_mixer
+        if (musicStream.open(getAssetPath("playlist.txt"), frequency))
+            return true;
+
+        std::string musicPath = getAssetPath("background_music.mp3");
         
         backgroundMusic = Mix_LoadMUS(musicPath.c_str());
         if (!backgroundMusic) {
@@ -151,6 +263,10 @@ bool AudioManager::loadMusic() {
 }
 
 void AudioManager::playMusic() {
+    if (musicStream.isOpen()) {
+        musicStream.setPlaying(true);
+        return;
+    }
     if (backgroundMusic && Mix_PlayingMusic() == 0) {
         if (Mix_PlayMusic(backgroundMusic, -1) == -1) {
             std::cerr << "Warning: Could not play music: " << Mix_GetError() << std::endl;
@@ -159,6 +275,10 @@ void AudioManager::playMusic() {
 }
 
 void AudioManager::pauseMusic() {
+    if (musicStream.isOpen()) {
+        musicStream.setPlaying(false);
+        return;
+    }
     try {
         if (Mix_PlayingMusic() == 1) {
             Mix_PauseMusic();
@@ -169,6 +289,10 @@ void AudioManager::pauseMusic() {
 }
 
 void AudioManager::resumeMusic() {
+    if (musicStream.isOpen()) {
+        musicStream.setPlaying(true);
+        return;
+    }
     try {
         if (Mix_PausedMusic() == 1) {
             Mix_ResumeMusic();
@@ -179,6 +303,10 @@ void AudioManager::resumeMusic() {
 }
 
 void AudioManager::stopMusic() {
+    if (musicStream.isOpen()) {
+        musicStream.setPlaying(false);
+        return;
+    }
     try {
         Mix_HaltMusic();
     } catch (...) {
@@ -186,21 +314,46 @@ void AudioManager::stopMusic() {
     }
 }
 
+void AudioManager::setMusicLevel(int level) {
+    musicStream.setLevel(level);
+}
+
 void AudioManager::playSound(SoundEffect effect) {
-    try {
-        auto it = soundEffects.find(effect);
-        if (it != soundEffects.end() && it->second != nullptr) {
-            if (Mix_PlayChannel(-1, it->second, 0) == -1) {
-                std::cerr << "Warning: Could not play sound effect: " << Mix_GetError() << std::endl;
-            }
-        } else {
-            std::cerr << "Warning: Attempted to play unavailable sound effect (ID: " << effect << ")" << std::endl;
+    if (!ready)
+        return;
+    if (!soundQueue.push({ effect, SDL_GetPerformanceCounter() }))
+        droppedSounds.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioManager::postMix(void *userdata, Uint8 *stream, int length) {
+    static_cast<AudioManager *>(userdata)->mixAudio(reinterpret_cast<int16_t *>(stream),
+                                                    static_cast<size_t>(length) / (2 * sizeof(int16_t)));
+}
+
+void AudioManager::mixAudio(int16_t *stream, size_t frames) {
+    musicStream.mix(stream, frames);
+
+    // This buffer is heard about one buffer from now. An event queued at
+    // time t is scheduled at mixer frame + frames - (now - t) * rate: the
+    // same delay for every sound, so they keep the spacing they were
+    // played with down to the sample instead of bunching up on buffer
+    // boundaries.
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 ticksPerSecond = SDL_GetPerformanceFrequency();
+    uint64_t bufferStart = mixer.getFrame();
+    SoundEvent event;
+
+    while (soundQueue.pop(event)) {
+        Uint64 waited = now > event.time ? now - event.time : 0;
+        if (waited * 1000 > AUDIO_MAX_DELAY_MS * ticksPerSecond) {
+            droppedSounds.fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Exception during playSound(): " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown exception during playSound()" << std::endl;
+        uint64_t age = waited * static_cast<Uint64>(frequency) / ticksPerSecond;
+        uint64_t start = bufferStart + frames;
+        mixer.trigger(event.effect, start > age ? start - age : 0);
     }
+    mixer.mix(stream, frames);
 }
 
 void AudioManager::setMusicVolume(int volume) {
@@ -208,17 +361,14 @@ void AudioManager::setMusicVolume(int volume) {
     
     int sdlVolume = static_cast<int>(musicVolume * 128 / 100);
     Mix_VolumeMusic(sdlVolume);
+    musicStream.setVolume(sdlVolume);
 }
 
 void AudioManager::setSoundVolume(int volume) {
     soundVolume = std::max(0, std::min(100, volume));
     int sdlVolume = static_cast<int>(soundVolume * 128 / 100);
     
-    for (auto& pair : soundEffects) {
-        if (pair.second) {
-            Mix_VolumeChunk(pair.second, sdlVolume);
-        }
-    }
+    mixer.setVolume(sdlVolume);
 }
 
 int AudioManager::getMusicVolume() const {
@@ -3,27 +3,76 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_mixer.h>
+#include "MusicStream.hpp"
+#include "SoundMixer.hpp"
+#include "SpscQueue.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <vector>
+// frames per device buffer: about 6 ms at 44.1 kHz (SDL_mixer's usual
+// 2048 is 46 ms, sounds waited for that long before being heard)
+#define AUDIO_BUFFER_FRAMES 256
+#define AUDIO_FREQUENCY 44100
+// sound events waiting for the audio callback, more in one buffer are dropped
+#define AUDIO_QUEUE_SIZE 64
+// a sound that waited longer than this is dropped, it would only sound late
+#define AUDIO_MAX_DELAY_MS 100
 
+// The audio service of the whole process: the mixer is opened and every
+// asset decoded once, then menus and games share it, so starting a new
+// game costs nothing audio-wise. Music is streamed from a level-keyed WAV
+// playlist when there is one (MusicStream), SDL_mixer plays the MP3
+// otherwise; sound effects go through a lock-free queue to our own
+// SoundMixer, run in the audio callback on a small buffer, each one
+// starting on the sample that matches when the game asked for it.
 class AudioManager {
     public:
         enum SoundEffect {
             ROTATE,
             PLACE,
             LINE_CLEAR,
-            GAME_OVER
+            GAME_OVER,
+            SOUND_COUNT
         };
 
-        AudioManager();
-        ~AudioManager();
+        static AudioManager &getInstance();
+
+        AudioManager(const AudioManager &) = delete;
+        AudioManager &operator=(const AudioManager &) = delete;
+
+        // how long each part of init() took, in milliseconds
+        struct LoadTimes {
+            double device;
+            double sounds;
+            double music;
+        };
 
+        // opens the mixer and loads the assets the first time, later calls
+        // only tell whether that worked (waiting for a first call still
+        // running on another thread, see AssetManager)
         bool init();
+        // closes the mixer, to be called before SDL_Quit
+        void shutdown();
+        // device buffer size used by the next init(), smaller is snappier
+        // but needs the callback to keep up
+        void setBufferFrames(int frames);
+        LoadTimes getLoadTimes() const { return loadTimes; }
         void playMusic();
         void pauseMusic();
         void resumeMusic();
         void stopMusic();
+        // picks the playlist track, switched at the end of the current one
+        void setMusicLevel(int level);
+        // underruns of the streamed music (all zero with SDL_mixer music)
+        MusicStream::Stats getMusicStats() const { return musicStream.getStats(); }
+        // queues the sound and returns at once; the game thread is the
+        // only one that may call it (single producer)
         void playSound(SoundEffect effect);
+        // sounds thrown away because the queue was full or they came too late
+        unsigned getDroppedSounds() const { return droppedSounds.load(std::memory_order_relaxed); }
         
         // Volume controls (0-100 range, will be converted to 0-128 for SDL_mixer)
         void setMusicVolume(int volume);
@@ -32,12 +81,38 @@ class AudioManager {
         int getSoundVolume() const;
 
     private:
+        AudioManager();
+        ~AudioManager();
+
+        // one or the other plays the music
+        MusicStream musicStream;
         Mix_Music *backgroundMusic;
-        std::unordered_map<SoundEffect, Mix_Chunk *> soundEffects;
+        // every sound effect already converted to the device format
+        // (16-bit stereo), back to back; the mixer voices point into it
+        std::vector<int16_t> soundBank;
         int musicVolume;  // (0-100)
         int soundVolume;  // (0-100)
+        int bufferFrames;
+        int frequency;
+        bool initialized;
+        bool ready;
+        // init() and shutdown() may run on a loader thread
+        std::mutex initMutex;
+        LoadTimes loadTimes;
+
+        struct SoundEvent {
+            SoundEffect effect;
+            Uint64 time;        // SDL_GetPerformanceCounter() when queued
+        };
+        SpscQueue<SoundEvent, AUDIO_QUEUE_SIZE> soundQueue;
+        std::atomic<unsigned> droppedSounds;
+        SoundMixer mixer;
 
+        std::string getAssetPath(const char *filename) const;
         bool loadSounds();
         bool loadMusic();
+        // Mix_SetPostMix callback, runs on the audio thread after SDL_mixer
+        static void postMix(void *userdata, Uint8 *stream, int length);
+        void mixAudio(int16_t *stream, size_t frames);
 };
 #endif /* __AUDIO_MANAGER__ */
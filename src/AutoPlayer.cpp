@@ -0,0 +1,181 @@
+#include "AutoPlayer.hpp"
+
+namespace {
+    // score of a line of play that tops out
+    const float LOSS = -1e9f;
+}
+
+AutoPlayer::AutoPlayer(const Evaluator &evaluator, int lookahead)
+    : evaluator(evaluator), lookahead(lookahead < 0 ? 0 : lookahead > MAX_LOOKAHEAD ? MAX_LOOKAHEAD : lookahead),
+      pathLength(0), pathIndex(0), plannedPiece(-1), expectedX(0), expectedY(0), targetX(0), targetY(0),
+      hasTarget(false) {
+    generators.resize(this->lookahead + 1);
+    placements.resize(this->lookahead + 1);
+    for (std::vector<MoveGenerator::Placement> &buffer : placements)
+        buffer.resize(MoveGenerator::MAX_PLACEMENTS);
+    leaves.resize(MoveGenerator::MAX_PLACEMENTS);
+    leafBoards.resize(MoveGenerator::MAX_PLACEMENTS);
+    leafLines.resize(MoveGenerator::MAX_PLACEMENTS);
+    leafScores.resize(MoveGenerator::MAX_PLACEMENTS);
+}
+
+AutoPlayer::AutoPlayer(std::unique_ptr<BeamSearch> planner)
+    : lookahead(0), planner(std::move(planner)), pathLength(0), pathIndex(0), plannedPiece(-1), expectedX(0),
+      expectedY(0), targetX(0), targetY(0), hasTarget(false) {
+    // repath() still looks the target up at depth 0, the lookahead and
+    // leaf buffers are for the evaluator search only
+    generators.resize(1);
+    placements.resize(1);
+    placements[0].resize(MoveGenerator::MAX_PLACEMENTS);
+}
+
+void AutoPlayer::reset() {
+    pathLength = 0;
+    pathIndex = 0;
+    plannedPiece = -1;
+    hasTarget = false;
+}
+
+Simulation::Action AutoPlayer::chooseAction(const Simulation &simulation) {
+    const Piece &piece = simulation.getCurrentPiece();
+    bool onPath = plannedPiece == simulation.getPieceCount() && pathIndex < pathLength &&
+                  simulation.getPieceX() == expectedX && simulation.getPieceY() == expectedY &&
+                  piece.getRotation() == expectedPiece.getRotation();
+    if (!onPath && !(plannedPiece == simulation.getPieceCount() && repath(simulation)))
+        plan(simulation);
+    if (pathIndex >= pathLength)
+        return Simulation::HARD_DROP;
+
+    Simulation::Action action = path[pathIndex++];
+    switch (action) {
+        case Simulation::MOVE_LEFT: expectedX--; break;
+        case Simulation::MOVE_RIGHT: expectedX++; break;
+        case Simulation::SOFT_DROP: expectedY++; break;
+        case Simulation::ROTATE:
+            Simulation::rotatePiece(simulation.getBoard(), expectedPiece, expectedX, expectedY);
+            break;
+        case Simulation::HOLD: {
+            const Piece *held = simulation.getHeldPiece();
+            expectedPiece = held ? *held : simulation.getNextPieces()[0];
+            expectedX = Simulation::SPAWN_X;
+            expectedY = Simulation::SPAWN_Y;
+            break;
+        }
+        default:
+            break;
+    }
+    return action;
+}
+
+void AutoPlayer::plan(const Simulation &simulation) {
+    if (planner) {
+        planBeam(simulation);
+        return;
+    }
+
+    const Board &board = simulation.getBoard();
+    std::vector<MoveGenerator::Placement> &found = placements[0];
+    int count = generators[0].generate(board, simulation.getCurrentPiece(), simulation.getPieceX(),
+                                       simulation.getPieceY(), found.data(), MoveGenerator::MAX_PLACEMENTS);
+    int best = -1;
+    float bestScore = LOSS;
+
+    for (int i = 0; i < count; ++i) {
+        Board next = board;
+        int lines = next.placePiece(found[i].piece, found[i].x, found[i].y);
+        float score = search(next, simulation.getNextPieces(), 1, lines);
+        if (best < 0 || score > bestScore) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    follow(simulation, 0);
+    hasTarget = false;
+    if (best >= 0) {
+        follow(simulation, generators[0].getPath(found[best], path.data(), PATH_CAPACITY));
+        targetPiece = found[best].piece;
+        targetX = found[best].x;
+        targetY = found[best].y;
+        hasTarget = true;
+    }
+}
+
+void AutoPlayer::planBeam(const Simulation &simulation) {
+    follow(simulation, 0);
+    hasTarget = false;
+    if (!planner->plan(simulation, beamPlan))
+        return;
+
+    follow(simulation, planner->getPath(beamPlan, path.data(), PATH_CAPACITY));
+    const BeamSearch::Step &first = beamPlan.steps[0];
+    targetPiece = first.piece;
+    targetX = first.x;
+    targetY = first.y;
+    hasTarget = true;
+}
+
+bool AutoPlayer::repath(const Simulation &simulation) {
+    // a hold still to come changes the piece, that needs a real plan
+    if (!hasTarget || (pathIndex == 0 && pathLength > 0 && path[0] == Simulation::HOLD))
+        return false;
+    const Piece &piece = simulation.getCurrentPiece();
+    if (piece.getTetromino() != targetPiece.getTetromino())
+        return false;
+
+    std::vector<MoveGenerator::Placement> &found = placements[0];
+    int count = generators[0].generate(simulation.getBoard(), piece, simulation.getPieceX(), simulation.getPieceY(),
+                                       found.data(), MoveGenerator::MAX_PLACEMENTS);
+    for (int i = 0; i < count; ++i) {
+        if (found[i].x != targetX || found[i].y != targetY ||
+            found[i].piece.getRotation() != targetPiece.getRotation())
+            continue;
+        int length = generators[0].getPath(found[i], path.data(), PATH_CAPACITY);
+        if (length <= 0)
+            return false;
+        follow(simulation, length);
+        return true;
+    }
+    return false;
+}
+
+void AutoPlayer::follow(const Simulation &simulation, int length) {
+    plannedPiece = simulation.getPieceCount();
+    pathIndex = 0;
+    pathLength = length > 0 ? length : 0;
+    expectedPiece = simulation.getCurrentPiece();
+    expectedX = simulation.getPieceX();
+    expectedY = simulation.getPieceY();
+}
+
+float AutoPlayer::search(const Board &board, const Simulation::Queue &queue, int depth, int lines) {
+    if (depth > lookahead)
+        return evaluator.evaluate(board, lines);
+
+    std::vector<MoveGenerator::Placement> &found = placements[depth];
+    int count = generators[depth].generate(board, queue[depth - 1], Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                           found.data(), MoveGenerator::MAX_PLACEMENTS);
+    float best = LOSS;
+    if (depth == lookahead) {
+        // last piece: the boards are only scored, all at once
+        for (int i = 0; i < count; ++i) {
+            leaves[i] = board;
+            leafLines[i] = lines + leaves[i].placePiece(found[i].piece, found[i].x, found[i].y);
+            leafBoards[i] = &leaves[i];
+        }
+        evaluator.evaluate(leafBoards.data(), leafLines.data(), count, leafScores.data());
+        for (int i = 0; i < count; ++i) {
+            if (leafScores[i] > best)
+                best = leafScores[i];
+        }
+        return best;
+    }
+    for (int i = 0; i < count; ++i) {
+        Board next = board;
+        int cleared = next.placePiece(found[i].piece, found[i].x, found[i].y);
+        float score = search(next, queue, depth + 1, lines + cleared);
+        if (score > best)
+            best = score;
+    }
+    return best;
+}
@@ -0,0 +1,67 @@
+#ifndef _AUTO_PLAYER_
+    #define _AUTO_PLAYER_
+#include "BeamSearch.hpp"
+#include "Evaluator.hpp"
+#include "MoveGenerator.hpp"
+#include "SelfPlay.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+// Built-in bot: for every new piece it tries each reachable placement,
+// looks ahead through the preview queue, keeps the best scoring one and
+// then feeds its input path one action per call, like a player would.
+// If gravity moves the piece off the planned path it finds a new path to
+// the same spot, and only plans again when that spot is out of reach.
+class AutoPlayer : public MovePolicy {
+    public:
+        static constexpr int MAX_LOOKAHEAD = NEXT_PIECE_COUNT;
+        static constexpr int PATH_CAPACITY = 256;
+
+        // lookahead: how many queued pieces are searched after the current
+        // one (1 is fast enough for every frame, each level multiplies the
+        // cost by the number of placements, about 30)
+        explicit AutoPlayer(const Evaluator &evaluator = Evaluator(), int lookahead = 1);
+        // plans with a beam search over the whole queue and the hold slot
+        // instead, see BeamSearch
+        explicit AutoPlayer(std::unique_ptr<BeamSearch> planner);
+        Simulation::Action chooseAction(const Simulation &simulation) override;
+        // forgets the plan in progress, so the same player (and its search
+        // threads and cache) can start another game
+        void reset();
+
+    private:
+        Evaluator evaluator;
+        int lookahead;
+
+        // one generator and placement buffer per search depth
+        std::vector<MoveGenerator> generators;
+        std::vector<std::vector<MoveGenerator::Placement>> placements;
+        // boards after the last lookahead piece, scored as one batch
+        std::vector<Board> leaves;
+        std::vector<const Board *> leafBoards;
+        std::vector<int> leafLines;
+        std::vector<float> leafScores;
+        std::unique_ptr<BeamSearch> planner;
+        BeamSearch::Plan beamPlan;
+
+        std::array<Simulation::Action, PATH_CAPACITY> path;
+        int pathLength;
+        int pathIndex;
+        int plannedPiece;
+        // where the piece should be if nothing but our inputs moved it
+        Piece expectedPiece;
+        int expectedX, expectedY;
+        // where the current piece is headed
+        Piece targetPiece;
+        int targetX, targetY;
+        bool hasTarget;
+
+        void plan(const Simulation &simulation);
+        void planBeam(const Simulation &simulation);
+        bool repath(const Simulation &simulation);
+        void follow(const Simulation &simulation, int length);
+        float search(const Board &board, const Simulation::Queue &queue, int depth, int lines);
+};
+
+#endif /* _AUTO_PLAYER_ */
@@ -0,0 +1,236 @@
+#include "BeamSearch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+}
+
+BeamSearch::BeamSearch() : BeamSearch(Evaluator(), Settings()) {}
+
+BeamSearch::BeamSearch(const Evaluator &evaluator, const Settings &settings)
+    : evaluator(evaluator), settings(settings), pool(settings.threads), arenas(pool.size()),
+      rootCount{{0, 0}}, sequenceLength(0) {
+    if (this->settings.beamWidth < 1)
+        this->settings.beamWidth = 1;
+    if (this->settings.tableBits > 0)
+        table.reset(new TranspositionTable(this->settings.tableBits));
+    for (Arena &arena : arenas) {
+        arena.placements.resize(MoveGenerator::MAX_PLACEMENTS);
+        arena.nodes = 0;
+    }
+    for (std::vector<MoveGenerator::Placement> &buffer : rootPlacements)
+        buffer.resize(MoveGenerator::MAX_PLACEMENTS);
+}
+
+bool BeamSearch::plan(const Simulation &simulation, Plan &result) {
+    Clock::time_point deadline = Clock::now() + std::chrono::microseconds(settings.deadlineMicros);
+    const Board &board = simulation.getBoard();
+    const Piece *held = simulation.getHeldPiece();
+    int nodes = 0;
+
+    // everything known: the current piece, then the preview queue
+    sequence[0] = simulation.getCurrentPiece();
+    for (int i = 0; i < NEXT_PIECE_COUNT; ++i)
+        sequence[i + 1] = simulation.getNextPieces()[i];
+    sequenceLength = MAX_DEPTH;
+
+    Node root;
+    root.board = board;
+    root.held = held ? *held : Piece();
+    root.hasHeld = held != nullptr;
+    root.next = 0;
+    root.depth = 0;
+    root.lines = 0;
+    root.score = 0.0f;
+    root.order = 0;
+
+    // first step on this thread, from where the piece actually is
+    candidates.clear();
+    rootCount[0] = rootGenerators[0].generate(board, sequence[0], simulation.getPieceX(), simulation.getPieceY(),
+                                              rootPlacements[0].data(), MoveGenerator::MAX_PLACEMENTS);
+    addChildren(root, 0, false, root.held, root.hasHeld, 1, rootPlacements[0].data(), rootCount[0],
+                candidates, nodes);
+    rootCount[1] = 0;
+    if (settings.useHold && simulation.canHoldPiece()) {
+        // same rules as Simulation::holdPiece: swap with the held piece, or
+        // stash the current one and take the next from the queue
+        const Piece &swapped = held ? *held : sequence[1];
+        rootCount[1] = rootGenerators[1].generate(board, swapped, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                                  rootPlacements[1].data(), MoveGenerator::MAX_PLACEMENTS);
+        addChildren(root, 0, true, sequence[0], true, held ? 1 : 2, rootPlacements[1].data(), rootCount[1],
+                    candidates, nodes);
+    }
+    if (candidates.empty())
+        return false;
+    score(candidates.data(), candidates.size(), arenas[0]);
+    keepBest(candidates, settings.beamWidth);
+    beam.swap(candidates);
+
+    for (int depth = 2; depth <= MAX_DEPTH; ++depth) {
+        if (settings.deadlineMicros > 0 && Clock::now() >= deadline)
+            break;
+
+        for (Arena &arena : arenas) {
+            arena.children.clear();
+            arena.nodes = 0;
+        }
+        // a depth cut short by the deadline is thrown away, its beam would
+        // only hold the children of the nodes that happened to run first
+        std::atomic<bool> expired(false);
+        pool.parallelFor(static_cast<int>(beam.size()), [&](int index, int worker) {
+            if (settings.deadlineMicros > 0 && Clock::now() >= deadline) {
+                expired.store(true, std::memory_order_relaxed);
+                return;
+            }
+            Arena &arena = arenas[worker];
+            size_t first = arena.children.size();
+            expand(beam[index], static_cast<uint32_t>(index), arena);
+            score(arena.children.data() + first, arena.children.size() - first, arena);
+        });
+        if (expired.load())
+            break;
+
+        candidates.clear();
+        for (Arena &arena : arenas) {
+            candidates.insert(candidates.end(), arena.children.begin(), arena.children.end());
+            nodes += arena.nodes;
+        }
+        // every line topped out or ran out of known pieces
+        if (candidates.empty())
+            break;
+        keepBest(candidates, settings.beamWidth);
+        beam.swap(candidates);
+    }
+
+    // keepBest leaves the beam sorted, best first
+    const Node &best = beam.front();
+    result.steps = best.steps;
+    result.length = best.depth;
+    result.score = best.score;
+    result.nodes = nodes;
+    return true;
+}
+
+void BeamSearch::expand(const Node &parent, uint32_t parentIndex, Arena &arena) {
+    if (parent.next >= sequenceLength)
+        return;
+
+    const Piece &piece = sequence[parent.next];
+    MoveGenerator::Placement *found = arena.placements.data();
+    int count = arena.generator.generate(parent.board, piece, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                         found, MoveGenerator::MAX_PLACEMENTS);
+    addChildren(parent, parentIndex, false, parent.held, parent.hasHeld, parent.next + 1, found, count,
+                arena.children, arena.nodes);
+    if (!settings.useHold)
+        return;
+
+    if (parent.hasHeld) {
+        // swapping two pieces of the same kind changes nothing
+        if (parent.held.getTetromino() == piece.getTetromino())
+            return;
+        count = arena.generator.generate(parent.board, parent.held, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                         found, MoveGenerator::MAX_PLACEMENTS);
+        addChildren(parent, parentIndex, true, piece, true, parent.next + 1, found, count,
+                    arena.children, arena.nodes);
+    } else if (parent.next + 1 < sequenceLength) {
+        const Piece &following = sequence[parent.next + 1];
+        count = arena.generator.generate(parent.board, following, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                         found, MoveGenerator::MAX_PLACEMENTS);
+        addChildren(parent, parentIndex, true, piece, true, parent.next + 2, found, count,
+                    arena.children, arena.nodes);
+    }
+}
+
+void BeamSearch::addChildren(const Node &parent, uint32_t parentIndex, bool hold, const Piece &held, bool hasHeld,
+                             int next, const MoveGenerator::Placement *found, int count,
+                             std::vector<Node> &out, int &nodes) {
+    for (int i = 0; i < count; ++i) {
+        out.push_back(parent);
+        Node &child = out.back();
+        int lines = child.board.placePiece(found[i].piece, found[i].x, found[i].y);
+
+        // the game ends if the following piece cannot spawn
+        if (next < sequenceLength &&
+            !child.board.isValidPosition(sequence[next], Simulation::SPAWN_X, Simulation::SPAWN_Y)) {
+            out.pop_back();
+            continue;
+        }
+        child.held = held;
+        child.hasHeld = hasHeld;
+        child.next = static_cast<uint8_t>(next);
+        child.steps[parent.depth] = { hold, found[i].piece, found[i].x, found[i].y };
+        child.depth = static_cast<uint8_t>(parent.depth + 1);
+        child.lines = parent.lines + lines;
+        child.order = (parentIndex * 2 + (hold ? 1 : 0)) * MoveGenerator::MAX_PLACEMENTS + i;
+        nodes++;
+    }
+}
+
+void BeamSearch::score(Node *nodes, size_t count, Arena &arena) {
+    // the cached part only depends on the cells, lines are added on top;
+    // what the table does not have goes through the batch kernel
+    float lineWeight = evaluator.getWeights().lines;
+    arena.pending.clear();
+    arena.pendingBoards.clear();
+    for (size_t i = 0; i < count; ++i) {
+        float shape;
+        if (table && table->probe(nodes[i].board.getHash(), shape)) {
+            nodes[i].score = shape + lineWeight * nodes[i].lines;
+        } else {
+            arena.pending.push_back(i);
+            arena.pendingBoards.push_back(&nodes[i].board);
+        }
+    }
+    if (arena.pending.empty())
+        return;
+
+    arena.features.resize(arena.pending.size());
+    Evaluator::computeFeatures(arena.pendingBoards.data(), static_cast<int>(arena.pending.size()),
+                               arena.features.data());
+    for (size_t j = 0; j < arena.pending.size(); ++j) {
+        Node &node = nodes[arena.pending[j]];
+        float shape = evaluator.evaluate(arena.features[j], 0);
+        if (table)
+            table->store(node.board.getHash(), shape);
+        node.score = shape + lineWeight * node.lines;
+    }
+}
+
+void BeamSearch::keepBest(std::vector<Node> &nodes, size_t width) {
+    // total order (order is unique within a depth), so the same boards are
+    // kept in the same order whatever thread produced them
+    auto better = [](const Node &a, const Node &b) {
+        return a.score != b.score ? a.score > b.score : a.order < b.order;
+    };
+    if (nodes.size() > width) {
+        std::nth_element(nodes.begin(), nodes.begin() + width, nodes.end(), better);
+        nodes.resize(width);
+    }
+    std::sort(nodes.begin(), nodes.end(), better);
+}
+
+int BeamSearch::getPath(const Plan &plan, Simulation::Action *out, int capacity) {
+    if (plan.length == 0)
+        return -1;
+
+    const Step &first = plan.steps[0];
+    int side = first.hold ? 1 : 0;
+    int offset = first.hold ? 1 : 0;
+    for (int i = 0; i < rootCount[side]; ++i) {
+        const MoveGenerator::Placement &placement = rootPlacements[side][i];
+        if (placement.x != first.x || placement.y != first.y ||
+            placement.piece.getRotation() != first.piece.getRotation())
+            continue;
+        if (capacity <= offset)
+            return -1;
+        int length = rootGenerators[side].getPath(placement, out + offset, capacity - offset);
+        if (length < 0)
+            return -1;
+        if (first.hold)
+            out[0] = Simulation::HOLD;
+        return length + offset;
+    }
+    return -1;
+}
@@ -0,0 +1,120 @@
+#ifndef _BEAM_SEARCH_
+    #define _BEAM_SEARCH_
+#include "Evaluator.hpp"
+#include "MoveGenerator.hpp"
+#include "Simulation.hpp"
+#include "ThreadPool.hpp"
+#include "TranspositionTable.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+// Plans several pieces ahead: the current piece, the preview queue and the
+// hold slot. Each depth expands every board kept in the beam with all
+// placements of the pieces it can play (with and without hold), spread
+// over a thread pool, then keeps the best beamWidth boards for the next
+// depth. Stops early at the deadline and answers with the best line found
+// at the deepest completed depth.
+class BeamSearch {
+    public:
+        // current piece plus the whole preview queue
+        static constexpr int MAX_DEPTH = NEXT_PIECE_COUNT + 1;
+
+        struct Settings {
+            int beamWidth = 48;
+            int deadlineMicros = 15000;     // <= 0: no deadline, always MAX_DEPTH
+            bool useHold = true;
+            int threads = 0;                // 0 = one per hardware thread
+            // board scores cached across depths and plans (the same stack
+            // is reached through hold and through pieces played in another
+            // order), 1 << tableBits entries, 0 = no cache
+            int tableBits = 18;
+        };
+
+        // one piece of the planned line
+        struct Step {
+            bool hold;          // hold first, then place
+            Piece piece;
+            int8_t x;
+            int8_t y;
+        };
+
+        struct Plan {
+            std::array<Step, MAX_DEPTH> steps;
+            int length;
+            float score;
+            int nodes;          // boards evaluated
+        };
+
+        BeamSearch();
+        BeamSearch(const Evaluator &evaluator, const Settings &settings);
+
+        BeamSearch(const BeamSearch &) = delete;
+        BeamSearch &operator=(const BeamSearch &) = delete;
+
+        // false when the current piece has nowhere to go
+        bool plan(const Simulation &simulation, Plan &result);
+        // inputs for the first step of the last plan(): HOLD if needed, the
+        // moves, HARD_DROP. Same contract as MoveGenerator::getPath().
+        int getPath(const Plan &plan, Simulation::Action *out, int capacity);
+
+        const Settings &getSettings() const { return settings; }
+        // nullptr when Settings::tableBits is 0
+        const TranspositionTable *getTable() const { return table.get(); }
+
+    private:
+        struct Node {
+            Board board;
+            Piece held;
+            bool hasHeld;
+            uint8_t next;       // index of the piece to play in the known sequence
+            uint8_t depth;
+            int lines;          // cleared along the line, rewarded by the evaluator
+            float score;
+            // position in the expansion order, ties are broken on it so the
+            // result does not depend on thread scheduling
+            uint32_t order;
+            std::array<Step, MAX_DEPTH> steps;
+        };
+
+        // scratch owned by one worker thread, reused from plan to plan
+        struct alignas(64) Arena {
+            MoveGenerator generator;
+            std::vector<MoveGenerator::Placement> placements;
+            std::vector<Node> children;
+            int nodes;
+            // boards missing from the table, scored as one batch
+            std::vector<size_t> pending;
+            std::vector<const Board *> pendingBoards;
+            std::vector<BoardFeatures> features;
+        };
+
+        Evaluator evaluator;
+        Settings settings;
+        ThreadPool pool;
+        std::unique_ptr<TranspositionTable> table;
+        std::vector<Arena> arenas;
+        std::vector<Node> beam;
+        std::vector<Node> candidates;
+
+        // the first step is searched from the live position, and its
+        // generators are kept so getPath() can walk back to it
+        std::array<MoveGenerator, 2> rootGenerators;
+        std::array<std::vector<MoveGenerator::Placement>, 2> rootPlacements;
+        std::array<int, 2> rootCount;
+
+        std::array<Piece, MAX_DEPTH> sequence;
+        int sequenceLength;
+
+        void expand(const Node &parent, uint32_t parentIndex, Arena &arena);
+        // one child per placement found, held/hasHeld/next: the hold slot
+        // and the piece to play after it
+        void addChildren(const Node &parent, uint32_t parentIndex, bool hold, const Piece &held, bool hasHeld,
+                         int next, const MoveGenerator::Placement *found, int count,
+                         std::vector<Node> &out, int &nodes);
+        void keepBest(std::vector<Node> &nodes, size_t width);
+        // fills in the score of nodes[0..count)
+        void score(Node *nodes, size_t count, Arena &arena);
+};
+
+#endif /* _BEAM_SEARCH_ */
@@ -1,32 +1,31 @@
 #include "Board.hpp"
-#include "AudioManager.hpp"
-#include <iostream>
+#include "Zobrist.hpp"
+#include <cstring>
+
+static_assert(Zobrist::WIDTH == Board::WIDTH && Zobrist::HEIGHT == Board::HEIGHT, "Zobrist keys sized for another board");
 
 Board::Board() {
-    grid.resize(WIDTH, std::vector<char>(HEIGHT, 0));
+    rows.fill(0);
+    cells.fill(0);
     score = 0;
     currentLevel = 1;
     linesCleared = 0;
-    audioManager = nullptr;
-}
-
-void Board::setAudioManager(AudioManager *manager) {
-    audioManager = manager;
+    lastClearedRows = 0;
+    cellsVersion = 0;
+    scoreVersion = 0;
+    hash = 0;
 }
 
 bool Board::isValidPosition(const Piece &piece, int posX, int posY) const {
-    const auto &shape = piece.getShape();
-    for (int x = 0; x < 5; ++x) {
-        for (int y = 0; y < 5; ++y) {
-            if (shape[x][y]) {
-                int boardX = posX + x;
-                int boardY = posY + y;
-                if (boardX < 0 || boardX >= WIDTH || boardY < 0 || boardY >= HEIGHT)
-                    return false;
-                if (grid[boardX][boardY] != 0)
-                    return false;
-            }
-        }
+    const Piece::Footprint &fp = piece.getFootprint();
+    int left = posX + fp.minX;
+    int top = posY + fp.minY;
+
+    if (left < 0 || left + fp.width > WIDTH || top < 0 || top + fp.height > HEIGHT)
+        return false;
+    for (int i = 0; i < fp.height; ++i) {
+        if (rows[top + i] & (fp.rowMasks[i] << left))
+            return false;
     }
     return true;
 }
@@ -61,6 +60,7 @@ void Board::updateScore(int lines) {
             break;
     }
     score += linePoints;
+    scoreVersion++;
     linesCleared += lines;
     if (linesCleared >= 10) {
         currentLevel++;
@@ -68,77 +68,92 @@ void Board::updateScore(int lines) {
     }
 }
 
-void Board::placePiece(const Piece &piece, int posX, int posY) {
-    const auto &shape = piece.getShape();
+int Board::placePiece(const Piece &piece, int posX, int posY) {
     char pieceType = piece.getType();
-    
-    for (int x = 0; x < 5; ++x) {
-        for (int y = 0; y < 5; ++y) {
-            if (shape[x][y]) {
-                int boardX = posX + x;
-                int boardY = posY + y;
-                
-                if (boardX >= 0 && boardX < WIDTH && boardY >= 0 && boardY < HEIGHT) {
-                    grid[boardX][boardY] = pieceType;
-                }
-            }
+
+    for (const Piece::Cell &cell : piece.getFootprint().cells) {
+        int boardX = posX + cell.x;
+        int boardY = posY + cell.y;
+
+        if (boardX >= 0 && boardX < WIDTH && boardY >= 0 && boardY < HEIGHT) {
+            uint16_t bit = static_cast<uint16_t>(1u << boardX);
+            if (!(rows[boardY] & bit))
+                hash ^= Zobrist::cell(boardX, boardY);
+            rows[boardY] |= bit;
+            cells[boardY * WIDTH + boardX] = pieceType;
         }
     }
+    cellsVersion++;
     int lines = clearFullLines();
     if (lines > 0) {
         updateScore(lines);
     }
+    return lines;
 }
 
 int Board::clearFullLines() {
-    int linesCleared = 0;
-    std::vector<int> fullLines;
-    for (int y = 0; y < HEIGHT; ++y) {
-        bool full = true;
-        for (int x = 0; x < WIDTH; ++x) {
-            if (grid[x][y] == 0) {
-                full = false;
-                break;
-            }
+    // stable bottom-up compaction: each surviving row is copied at most
+    // once, straight to its final place, and nothing is allocated
+    uint32_t cleared = 0;
+    int count = 0;
+    int write = HEIGHT - 1;
+
+    for (int read = HEIGHT - 1; read >= 0; --read) {
+        if (rows[read] == FULL_ROW) {
+            hash ^= Zobrist::row(read, FULL_ROW);
+            cleared |= 1u << read;
+            count++;
+            continue;
         }
-        if (full) {
-            fullLines.push_back(y);
+        if (write != read) {
+            // only the rows that move are rehashed, the ones below the
+            // lowest clear keep their keys
+            hash ^= Zobrist::row(read, rows[read]) ^ Zobrist::row(write, rows[read]);
+            rows[write] = rows[read];
+            std::memcpy(&cells[write * WIDTH], &cells[read * WIDTH], WIDTH * sizeof(cells[0]));
         }
+        write--;
     }
-    linesCleared = fullLines.size();
-    for (int fullY : fullLines) {
-        for (int y = fullY; y > 0; --y) {
-            for (int x = 0; x < WIDTH; ++x) {
-                grid[x][y] = grid[x][y - 1];
-            }
-        }
-        for (int x = 0; x < WIDTH; ++x) {
-            grid[x][0] = 0;
-        }
+    // the rows freed at the top are empty, what they held was already
+    // taken out of the hash when it was cleared or moved
+    for (; write >= 0; --write) {
+        rows[write] = 0;
+        std::memset(&cells[write * WIDTH], 0, WIDTH * sizeof(cells[0]));
     }
+    lastClearedRows = cleared;
+    if (count > 0)
+        cellsVersion++;
 
-    try {
-        if (linesCleared > 0 && audioManager != nullptr) {
-            audioManager->playSound(AudioManager::LINE_CLEAR);
-        }
-    } catch (...) {
-        std::cerr << "Warning: Exception when playing line clear sound" << std::endl;
-    }
+    return count;
+}
 
-    return linesCleared;
+char Board::getCell(int x, int y) const {
+    return cells[y * WIDTH + x];
 }
 
-const std::vector<std::vector<char>>& Board::getGrid() const {
-    return grid;
+uint16_t Board::getRow(int y) const {
+    return rows[y];
+}
+
+void Board::setRow(int y, uint16_t mask, char type) {
+    hash ^= Zobrist::row(y, rows[y]) ^ Zobrist::row(y, mask & FULL_ROW);
+    rows[y] = mask & FULL_ROW;
+    for (int x = 0; x < WIDTH; ++x) {
+        cells[y * WIDTH + x] = (rows[y] >> x) & 1 ? type : 0;
+    }
+    cellsVersion++;
 }
 
 void Board::setLevel(int level) {
-    if (level > 0) 
+    if (level > 0) {
         currentLevel = level;
+        scoreVersion++;
+    }
 }
 
 void Board::setScore(int newScore) {
     score = newScore;
+    scoreVersion++;
 }
 
 int Board::getScore() const {
@@ -148,3 +163,43 @@ int Board::getScore() const {
 int Board::getLevel() const {
     return currentLevel;
 }
+
+uint32_t Board::getLastClearedRows() const {
+    return lastClearedRows;
+}
+
+uint32_t Board::getCellsVersion() const {
+    return cellsVersion;
+}
+
+uint32_t Board::getScoreVersion() const {
+    return scoreVersion;
+}
+
+uint64_t Board::getHash() const {
+    return hash;
+}
+
+Board::Snapshot Board::snapshot() const {
+    Snapshot saved;
+    saved.rows = rows;
+    saved.cells = cells;
+    saved.linesCleared = linesCleared;
+    saved.currentLevel = currentLevel;
+    saved.score = score;
+    saved.lastClearedRows = lastClearedRows;
+    saved.hash = hash;
+    return saved;
+}
+
+void Board::restore(const Snapshot &saved) {
+    rows = saved.rows;
+    cells = saved.cells;
+    linesCleared = saved.linesCleared;
+    currentLevel = saved.currentLevel;
+    score = saved.score;
+    lastClearedRows = saved.lastClearedRows;
+    hash = saved.hash;
+    cellsVersion++;
+    scoreVersion++;
+}
@@ -1,33 +1,69 @@
 #ifndef _BOARD_
     #define _BOARD_
 #include "Piece.hpp"
-#include <vector>
-
-class AudioManager;
-class Game;
+#include <array>
+#include <cstdint>
 
 class Board {
     public:
         static constexpr int WIDTH = 10;
         static constexpr int HEIGHT = 20;
+        // a row is full when its WIDTH low bits are all set
+        static constexpr uint16_t FULL_ROW = (1u << WIDTH) - 1;
+
+        // everything but the version counters, plain bytes that can be
+        // copied around and restored later (see Simulation::Snapshot)
+        struct Snapshot {
+            std::array<uint16_t, HEIGHT> rows;
+            std::array<char, WIDTH * HEIGHT> cells;
+            int32_t linesCleared;
+            int32_t currentLevel;
+            int32_t score;
+            uint32_t lastClearedRows;
+            uint64_t hash;
+        };
 
         Board();
-        void setAudioManager(AudioManager *manager);
         bool isValidPosition(const Piece &piece, int x, int y) const;
         int findDropPosition(const Piece &piece, int x, int y) const;
-        void placePiece(const Piece &piece, int x, int y);
+        int placePiece(const Piece &piece, int x, int y);
         int clearFullLines();
-        const std::vector<std::vector<char>>& getGrid() const;
+        // bit y is set when row y (numbered before the clear) was removed by
+        // the last clearFullLines, 0 when it cleared nothing
+        uint32_t getLastClearedRows() const;
+        char getCell(int x, int y) const;
+        uint16_t getRow(int y) const;
+        // overwrites row y with the cells of mask, all of the given type
+        // (garbage lines, test and benchmark fixtures)
+        void setRow(int y, uint16_t mask, char type);
         int getScore() const;
         void setScore(int score);
         int getLevel() const;
         void updateScore(int lines);
         void setLevel(int level);
+        // bumped on every change to the cells / to score or level, so
+        // renderers can tell when there is nothing new to draw
+        uint32_t getCellsVersion() const;
+        uint32_t getScoreVersion() const;
+        // Zobrist hash of the occupied cells (piece types, score and level
+        // left out), kept up to date by every change to the cells
+        uint64_t getHash() const;
+
+        Snapshot snapshot() const;
+        // puts the board back as it was; the versions are bumped, not
+        // restored, so renderers see a change
+        void restore(const Snapshot &saved);
     private:
-        std::vector<std::vector<char>> grid;
+        // bit x of rows[y] is set when cell (x, y) is occupied
+        std::array<uint16_t, HEIGHT> rows;
+        // piece type of each cell, row-major (cells[y * WIDTH + x]), 0 when empty
+        std::array<char, WIDTH * HEIGHT> cells;
         int linesCleared;
+        uint32_t lastClearedRows;
         int currentLevel;
         int score;
-        AudioManager *audioManager;
+        uint32_t cellsVersion;
+        uint32_t scoreVersion;
+        uint64_t hash;
 };
 #endif /* _BOARD_ */
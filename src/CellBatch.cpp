@@ -0,0 +1,77 @@
+#include "CellBatch.hpp"
+
+CellBatch::CellBatch(SDL_Renderer *r) : renderer(r) {}
+
+CellBatch::Colour CellBatch::colourOf(char pieceType, bool isGhost) {
+    if (isGhost)
+        return GHOST_GREY;
+
+    switch (pieceType) {
+        case 'I': return CYAN;
+        case 'O': return YELLOW;
+        case 'T': return PURPLE;
+        case 'S': return GREEN;
+        case 'Z': return RED;
+        case 'J': return BLUE;
+        case 'L': return ORANGE;
+        default:  return RED;       // unknown types draw red
+    }
+}
+
+SDL_Color CellBatch::rgba(Colour colour) {
+    switch (colour) {
+        case CYAN:       return { 0, 255, 255, 255 };
+        case YELLOW:     return { 255, 255, 0, 255 };   // jaune
+        case PURPLE:     return { 128, 0, 128, 255 };   // violet
+        case GREEN:      return { 0, 255, 0, 255 };     // vert
+        case BLUE:       return { 0, 0, 255, 255 };     // bleu
+        case ORANGE:     return { 255, 165, 0, 255 };
+        case GHOST_GREY: return { 100, 100, 100, 255 };
+        default:         return { 255, 0, 0, 255 };     // rouge
+    }
+}
+
+bool CellBatch::push(Bucket &bucket, const SDL_Rect &rect) {
+    if (bucket.count == CAPACITY)
+        return false;
+    bucket.rects[bucket.count++] = rect;
+    return true;
+}
+
+void CellBatch::addBlock(Colour colour, const SDL_Rect &rect) {
+    if (fills[colour].count == CAPACITY || borders.count == CAPACITY)
+        flush();
+    push(fills[colour], rect);
+    push(borders, rect);
+}
+
+void CellBatch::addOutline(Colour colour, const SDL_Rect &rect) {
+    if (!push(outlines[colour], rect)) {
+        flush();
+        push(outlines[colour], rect);
+    }
+}
+
+void CellBatch::flush() {
+    for (int c = 0; c < COLOUR_COUNT; ++c) {
+        if (outlines[c].count == 0)
+            continue;
+        SDL_Color color = rgba(static_cast<Colour>(c));
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderDrawRects(renderer, outlines[c].rects.data(), outlines[c].count);
+        outlines[c].count = 0;
+    }
+    for (int c = 0; c < COLOUR_COUNT; ++c) {
+        if (fills[c].count == 0)
+            continue;
+        SDL_Color color = rgba(static_cast<Colour>(c));
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        SDL_RenderFillRects(renderer, fills[c].rects.data(), fills[c].count);
+        fills[c].count = 0;
+    }
+    if (borders.count > 0) {
+        SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+        SDL_RenderDrawRects(renderer, borders.rects.data(), borders.count);
+        borders.count = 0;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef _CELL_BATCH_
+#define _CELL_BATCH_
+
+#include <SDL2/SDL.h>
+#include <array>
+
+// Collects the board, ghost and preview cells of a frame and submits them
+// bucketed by colour with SDL_RenderFillRects / SDL_RenderDrawRects, so a
+// frame costs a dozen draw calls instead of several per cell. All storage
+// is fixed-size and reused from frame to frame.
+class CellBatch {
+    public:
+        enum Colour {
+            CYAN, YELLOW, PURPLE, GREEN, RED, BLUE, ORANGE,
+            GHOST_GREY,
+            COLOUR_COUNT
+        };
+
+        explicit CellBatch(SDL_Renderer *r);
+
+        static Colour colourOf(char pieceType, bool isGhost = false);
+        static SDL_Color rgba(Colour colour);
+
+        // filled cell with the dark border used for every block
+        void addBlock(Colour colour, const SDL_Rect &rect);
+        // outline only, drawn underneath the blocks (ghost piece)
+        void addOutline(Colour colour, const SDL_Rect &rect);
+        // draws everything queued: outlines, then fills, then block borders
+        void flush();
+
+    private:
+        static constexpr int CAPACITY = 256;
+
+        struct Bucket {
+            std::array<SDL_Rect, CAPACITY> rects;
+            int count = 0;
+        };
+
+        SDL_Renderer *renderer;
+        std::array<Bucket, COLOUR_COUNT> outlines;
+        std::array<Bucket, COLOUR_COUNT> fills;
+        Bucket borders;
+
+        bool push(Bucket &bucket, const SDL_Rect &rect);
+};
+
+#endif /* _CELL_BATCH_ */
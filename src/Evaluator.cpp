@@ -0,0 +1,40 @@
+#include "Evaluator.hpp"
+#include <algorithm>
+#include <array>
+
+Evaluator::Evaluator() : weights() {}
+
+Evaluator::Evaluator(const Weights &weights) : weights(weights) {}
+
+BoardFeatures Evaluator::computeFeatures(const Board &board) {
+    return FeatureKernel::compute(board);
+}
+
+void Evaluator::computeFeatures(const Board *const *boards, int count, BoardFeatures *out) {
+    FeatureKernel::compute(boards, count, out);
+}
+
+float Evaluator::evaluate(const BoardFeatures &features, int linesCleared) const {
+    return weights.aggregateHeight * features.aggregateHeight
+         + weights.lines * linesCleared
+         + weights.holes * features.holes
+         + weights.bumpiness * features.bumpiness
+         + weights.wells * features.wells
+         + weights.rowTransitions * features.rowTransitions
+         + weights.columnTransitions * features.columnTransitions;
+}
+
+float Evaluator::evaluate(const Board &board, int linesCleared) const {
+    return evaluate(computeFeatures(board), linesCleared);
+}
+
+void Evaluator::evaluate(const Board *const *boards, const int *linesCleared, int count, float *scores) const {
+    // a few kernel groups at a time, the features stay on the stack
+    std::array<BoardFeatures, 64> features;
+    for (int first = 0; first < count; first += static_cast<int>(features.size())) {
+        int group = std::min(static_cast<int>(features.size()), count - first);
+        computeFeatures(boards + first, group, features.data());
+        for (int i = 0; i < group; ++i)
+            scores[first + i] = evaluate(features[i], linesCleared[first + i]);
+    }
+}
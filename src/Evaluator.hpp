@@ -0,0 +1,38 @@
+#ifndef _EVALUATOR_
+    #define _EVALUATOR_
+#include "Board.hpp"
+#include "FeatureKernel.hpp"
+
+// Weighted sum of the board features plus the lines the placement cleared.
+// Higher is better.
+class Evaluator {
+    public:
+        struct Weights {
+            float aggregateHeight = -0.510066f;
+            float lines = 0.760666f;
+            float holes = -0.35663f;
+            float bumpiness = -0.184483f;
+            float wells = -0.1f;
+            // not part of the tuned set, off unless asked for
+            float rowTransitions = 0.0f;
+            float columnTransitions = 0.0f;
+        };
+
+        Evaluator();
+        explicit Evaluator(const Weights &weights);
+
+        float evaluate(const Board &board, int linesCleared) const;
+        float evaluate(const BoardFeatures &features, int linesCleared) const;
+        // scores[i] = evaluate(*boards[i], linesCleared[i]), through the
+        // batch feature kernel
+        void evaluate(const Board *const *boards, const int *linesCleared, int count, float *scores) const;
+        const Weights &getWeights() const { return weights; }
+
+        static BoardFeatures computeFeatures(const Board &board);
+        static void computeFeatures(const Board *const *boards, int count, BoardFeatures *out);
+
+    private:
+        Weights weights;
+};
+
+#endif /* _EVALUATOR_ */
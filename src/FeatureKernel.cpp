@@ -0,0 +1,173 @@
+#include "FeatureKernel.hpp"
+#include "FeatureKernelImpl.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static_assert(FeatureKernelImpl::WIDTH == Board::WIDTH && FeatureKernelImpl::HEIGHT == Board::HEIGHT,
+              "feature kernel built for another board size");
+
+namespace {
+    using namespace FeatureKernelImpl;
+
+    // bits set in every byte, without relying on a popcount instruction
+    struct ByteCounts {
+        uint8_t counts[256];
+
+        constexpr ByteCounts() : counts() {
+            for (int i = 1; i < 256; ++i)
+                counts[i] = static_cast<uint8_t>((i & 1) + counts[i >> 1]);
+        }
+    };
+    constexpr ByteCounts BYTE_COUNTS;
+
+    // one board, the plain bitboard
+    struct ScalarOps {
+        using V = uint32_t;
+        static constexpr int LANES = 1;
+
+        static V zero() { return 0; }
+        static V set(uint16_t value) { return value; }
+        static V load(const uint16_t *p) { return *p; }
+        static void store(uint16_t *p, V v) { *p = static_cast<uint16_t>(v); }
+
+        static V bitAnd(V a, V b) { return a & b; }
+        static V bitOr(V a, V b) { return a | b; }
+        static V bitXor(V a, V b) { return a ^ b; }
+        static V andNot(V a, V b) { return ~a & b; }
+        static V shiftLeft1(V a) { return (a << 1) & 0xFFFF; }
+        static V shiftRight1(V a) { return a >> 1; }
+        static V add(V a, V b) { return (a + b) & 0xFFFF; }
+        static V nonZero(V a) { return a ? 0xFFFF : 0; }
+        static V popcount(V a) { return BYTE_COUNTS.counts[a & 0xFF] + BYTE_COUNTS.counts[(a >> 8) & 0xFF]; }
+    };
+
+#if defined(__SSE2__)
+    struct Sse2Ops {
+        using V = __m128i;
+        static constexpr int LANES = 8;
+
+        static V zero() { return _mm_setzero_si128(); }
+        static V set(uint16_t value) { return _mm_set1_epi16(static_cast<short>(value)); }
+        static V load(const uint16_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+        static void store(uint16_t *p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+
+        static V bitAnd(V a, V b) { return _mm_and_si128(a, b); }
+        static V bitOr(V a, V b) { return _mm_or_si128(a, b); }
+        static V bitXor(V a, V b) { return _mm_xor_si128(a, b); }
+        static V andNot(V a, V b) { return _mm_andnot_si128(a, b); }        // ~a & b
+        static V shiftLeft1(V a) { return _mm_slli_epi16(a, 1); }
+        static V shiftRight1(V a) { return _mm_srli_epi16(a, 1); }
+        static V add(V a, V b) { return _mm_add_epi16(a, b); }
+        static V nonZero(V a) { return _mm_xor_si128(_mm_cmpeq_epi16(a, zero()), set(0xFFFF)); }
+
+        // no byte shuffle in SSE2, the classic SWAR count on 16-bit lanes
+        static V popcount(V a) {
+            a = _mm_sub_epi16(a, _mm_and_si128(_mm_srli_epi16(a, 1), set(0x5555)));
+            a = _mm_add_epi16(_mm_and_si128(a, set(0x3333)), _mm_and_si128(_mm_srli_epi16(a, 2), set(0x3333)));
+            a = _mm_and_si128(_mm_add_epi16(a, _mm_srli_epi16(a, 4)), set(0x0F0F));
+            return _mm_and_si128(_mm_add_epi16(a, _mm_srli_epi16(a, 8)), set(0x1F));
+        }
+    };
+#endif
+
+    FeatureKernel::Isa detect() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return FeatureKernel::AVX2;
+#endif
+#if defined(__SSE2__)
+        return FeatureKernel::SSE2;
+#else
+        return FeatureKernel::SCALAR;
+#endif
+    }
+
+    BoardFeatures unpack(const uint16_t *out, int lanes, int lane) {
+        BoardFeatures features;
+        features.aggregateHeight = out[AGGREGATE_HEIGHT * lanes + lane];
+        features.holes = out[HOLES * lanes + lane];
+        features.bumpiness = out[BUMPINESS * lanes + lane];
+        features.wells = out[WELLS * lanes + lane];
+        features.maxHeight = out[MAX_HEIGHT * lanes + lane];
+        features.rowTransitions = out[ROW_TRANSITIONS * lanes + lane];
+        features.columnTransitions = out[COLUMN_TRANSITIONS * lanes + lane];
+        return features;
+    }
+
+    // boards go in groups of lanes, one row of every board per vector;
+    // the last group is padded with empty boards
+    void computeGroups(const Board *const *boards, int count, BoardFeatures *out, int lanes,
+                       void (*kernel)(const uint16_t *, uint16_t *)) {
+        alignas(32) uint16_t rows[HEIGHT * AVX2_LANES];
+        alignas(32) uint16_t results[OUTPUT_COUNT * AVX2_LANES];
+
+        for (int first = 0; first < count; first += lanes) {
+            int group = std::min(lanes, count - first);
+            for (int lane = 0; lane < group; ++lane) {
+                const Board &board = *boards[first + lane];
+                for (int y = 0; y < HEIGHT; ++y)
+                    rows[y * lanes + lane] = board.getRow(y);
+            }
+            for (int lane = group; lane < lanes; ++lane) {
+                for (int y = 0; y < HEIGHT; ++y)
+                    rows[y * lanes + lane] = 0;
+            }
+            kernel(rows, results);
+            for (int lane = 0; lane < group; ++lane)
+                out[first + lane] = unpack(results, lanes, lane);
+        }
+    }
+}
+
+FeatureKernel::Isa FeatureKernel::getBest() {
+    static const Isa best = detect();
+    return best;
+}
+
+bool FeatureKernel::isSupported(Isa isa) {
+    return isa <= getBest();
+}
+
+const char *FeatureKernel::getName(Isa isa) {
+    switch (isa) {
+        case SSE2: return "sse2";
+        case AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+BoardFeatures FeatureKernel::compute(const Board &board) {
+    std::array<uint16_t, HEIGHT> rows;
+    uint16_t results[OUTPUT_COUNT];
+    for (int y = 0; y < HEIGHT; ++y)
+        rows[y] = board.getRow(y);
+    FeatureKernelImpl::compute<ScalarOps>(rows.data(), results);
+    return unpack(results, 1, 0);
+}
+
+void FeatureKernel::compute(const Board *const *boards, int count, BoardFeatures *out) {
+    compute(boards, count, out, getBest());
+}
+
+void FeatureKernel::compute(const Board *const *boards, int count, BoardFeatures *out, Isa isa) {
+    if (!isSupported(isa))
+        isa = SCALAR;
+    switch (isa) {
+#if defined(__SSE2__)
+        case AVX2:
+            computeGroups(boards, count, out, AVX2_LANES, computeAvx2);
+            break;
+        case SSE2:
+            computeGroups(boards, count, out, Sse2Ops::LANES, FeatureKernelImpl::compute<Sse2Ops>);
+            break;
+#endif
+        default:
+            for (int i = 0; i < count; ++i)
+                out[i] = compute(*boards[i]);
+            break;
+    }
+}
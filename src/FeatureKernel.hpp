@@ -0,0 +1,41 @@
+#ifndef _FEATURE_KERNEL_
+    #define _FEATURE_KERNEL_
+#include "Board.hpp"
+
+// Shape of the stack, what the autoplayer judges a position by.
+struct BoardFeatures {
+    int aggregateHeight;    // sum of the column heights
+    int holes;              // empty cells with a filled cell somewhere above
+    int bumpiness;          // sum of height differences between neighbouring columns
+    int wells;              // sum of the depths of columns lower than both neighbours (walls count as full)
+    int maxHeight;
+    int rowTransitions;     // filled/empty changes along the non-empty rows, walls count as full
+    int columnTransitions;  // filled/empty changes down the columns, the floor counts as full
+};
+
+// Computes BoardFeatures straight from the Board row bitmasks, for one
+// board or a batch of candidates. The batch kernels put one board per
+// 16-bit SIMD lane, 8 boards per SSE2 pass and 16 per AVX2 pass; the
+// widest one the CPU supports is picked at runtime. Every kernel runs the
+// same code (FeatureKernelImpl.hpp) and gives the same results.
+class FeatureKernel {
+    public:
+        enum Isa {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        // widest kernel this CPU can run, detected once
+        static Isa getBest();
+        static bool isSupported(Isa isa);
+        static const char *getName(Isa isa);
+
+        static BoardFeatures compute(const Board &board);
+        // features of boards[0..count) into out[0..count)
+        static void compute(const Board *const *boards, int count, BoardFeatures *out);
+        // same with a given kernel, falls back to SCALAR when unsupported
+        static void compute(const Board *const *boards, int count, BoardFeatures *out, Isa isa);
+};
+
+#endif /* _FEATURE_KERNEL_ */
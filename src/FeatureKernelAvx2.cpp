@@ -0,0 +1,49 @@
+// Built with -mavx2 (see the Makefile) and only called after a runtime
+// check, keep every other include out of this file.
+#include "FeatureKernelImpl.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+namespace {
+    struct Avx2Ops {
+        using V = __m256i;
+        static constexpr int LANES = FeatureKernelImpl::AVX2_LANES;
+
+        static V zero() { return _mm256_setzero_si256(); }
+        static V set(uint16_t value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+        static V load(const uint16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+        static void store(uint16_t *p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+
+        static V bitAnd(V a, V b) { return _mm256_and_si256(a, b); }
+        static V bitOr(V a, V b) { return _mm256_or_si256(a, b); }
+        static V bitXor(V a, V b) { return _mm256_xor_si256(a, b); }
+        static V andNot(V a, V b) { return _mm256_andnot_si256(a, b); }     // ~a & b
+        static V shiftLeft1(V a) { return _mm256_slli_epi16(a, 1); }
+        static V shiftRight1(V a) { return _mm256_srli_epi16(a, 1); }
+        static V add(V a, V b) { return _mm256_add_epi16(a, b); }
+        static V nonZero(V a) { return _mm256_xor_si256(_mm256_cmpeq_epi16(a, zero()), set(0xFFFF)); }
+
+        // nibble lookup per byte, then the two bytes of each lane summed
+        static V popcount(V a) {
+            const V table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const V nibble = _mm256_set1_epi8(0x0F);
+            V low = _mm256_shuffle_epi8(table, _mm256_and_si256(a, nibble));
+            V high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(a, 4), nibble));
+            V bytes = _mm256_add_epi8(low, high);
+            return _mm256_and_si256(_mm256_add_epi16(bytes, _mm256_srli_epi16(bytes, 8)), set(0x1F));
+        }
+    };
+}
+
+void FeatureKernelImpl::computeAvx2(const uint16_t *rows, uint16_t *out) {
+    compute<Avx2Ops>(rows, out);
+}
+
+#else
+
+// never called: the dispatcher only picks AVX2 on x86
+void FeatureKernelImpl::computeAvx2(const uint16_t *, uint16_t *) {}
+
+#endif
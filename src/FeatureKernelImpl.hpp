@@ -0,0 +1,159 @@
+#ifndef _FEATURE_KERNEL_IMPL_
+    #define _FEATURE_KERNEL_IMPL_
+#include <cstdint>
+
+// Body of the board feature kernel, shared by the scalar, SSE2 and AVX2
+// builds. Only <cstdint> is included on purpose: FeatureKernelAvx2.cpp is
+// compiled with -mavx2 and must not instantiate inline library code the
+// linker could pick for the rest of the program.
+//
+// Ops is one lane type: V holds Ops::LANES 16-bit lanes, one board per lane,
+// and every operation works lane by lane. Inside a lane a board row is the
+// Board bitmask, bit x for column x, so the column work is done on all
+// columns at once with shifts and bitwise operations.
+//
+// Column heights are kept bit-sliced: heights[k] has bit x set when bit k
+// of the height of column x is set. Going down the rows, covered (the
+// columns with a filled cell at or above the row) is added to that
+// counter, so each column counts the rows from its top cell to the floor,
+// which is its height. Differences, minimums and maximums of heights are
+// then ripple-borrow subtractions on the five planes.
+namespace FeatureKernelImpl {
+    constexpr int WIDTH = 10;
+    constexpr int HEIGHT = 20;
+    constexpr int PLANES = 5;           // heights go up to HEIGHT < 32
+    constexpr uint16_t FULL_ROW = (1u << WIDTH) - 1;
+
+    enum Output {
+        AGGREGATE_HEIGHT,
+        HOLES,
+        BUMPINESS,
+        WELLS,
+        MAX_HEIGHT,
+        ROW_TRANSITIONS,
+        COLUMN_TRANSITIONS,
+        OUTPUT_COUNT
+    };
+
+    // a - b on bit-sliced numbers, returns the borrow out (lanes where a < b)
+    template <class Ops>
+    typename Ops::V subtract(const typename Ops::V *a, const typename Ops::V *b, typename Ops::V *out) {
+        using V = typename Ops::V;
+        V borrow = Ops::zero();
+        for (int k = 0; k < PLANES; ++k) {
+            V diff = Ops::bitXor(a[k], b[k]);
+            out[k] = Ops::bitXor(diff, borrow);
+            borrow = Ops::bitOr(Ops::andNot(a[k], b[k]), Ops::andNot(diff, borrow));
+        }
+        return borrow;
+    }
+
+    // sum over the planes of popcount(plane & mask) << k
+    template <class Ops>
+    typename Ops::V weightedCount(const typename Ops::V *planes, typename Ops::V mask) {
+        typename Ops::V sum = Ops::zero();
+        for (int k = PLANES - 1; k >= 0; --k)
+            sum = Ops::add(Ops::add(sum, sum), Ops::popcount(Ops::bitAnd(planes[k], mask)));
+        return sum;
+    }
+
+    // rows[y * Ops::LANES + lane]: row y of the board in lane; writes
+    // out[output * Ops::LANES + lane]
+    template <class Ops>
+    void compute(const uint16_t *rows, uint16_t *out) {
+        using V = typename Ops::V;
+        const V full = Ops::set(FULL_ROW);
+        // walls count as filled on both sides of the row transitions
+        const V walls = Ops::set(static_cast<uint16_t>(1u | (1u << (WIDTH + 1))));
+        const V extended = Ops::set(static_cast<uint16_t>((1u << (WIDTH + 1)) - 1));
+
+        V heights[PLANES];
+        for (V &plane : heights)
+            plane = Ops::zero();
+        V covered = Ops::zero();
+        V previous = Ops::zero();
+        V holes = Ops::zero();
+        V rowTransitions = Ops::zero();
+        V columnTransitions = Ops::zero();
+
+        for (int y = 0; y < HEIGHT; ++y) {
+            V row = Ops::load(rows + y * Ops::LANES);
+
+            holes = Ops::add(holes, Ops::popcount(Ops::andNot(row, covered)));
+            covered = Ops::bitOr(covered, row);
+            V carry = covered;
+            for (V &plane : heights) {
+                V next = Ops::bitAnd(plane, carry);
+                plane = Ops::bitXor(plane, carry);
+                carry = next;
+            }
+
+            // empty rows above the stack are left out
+            V bordered = Ops::bitOr(Ops::shiftLeft1(row), walls);
+            V changes = Ops::popcount(Ops::bitAnd(Ops::bitXor(bordered, Ops::shiftRight1(bordered)), extended));
+            rowTransitions = Ops::add(rowTransitions, Ops::bitAnd(changes, Ops::nonZero(row)));
+            columnTransitions = Ops::add(columnTransitions, Ops::popcount(Ops::bitXor(previous, row)));
+            previous = row;
+        }
+        // the floor counts as filled
+        columnTransitions = Ops::add(columnTransitions, Ops::popcount(Ops::andNot(previous, full)));
+
+        // tallest column: keep the columns with the highest bits set, top plane first
+        V candidates = full;
+        V maxHeight = Ops::zero();
+        for (int k = PLANES - 1; k >= 0; --k) {
+            V both = Ops::bitAnd(candidates, heights[k]);
+            V found = Ops::nonZero(both);
+            candidates = Ops::bitOr(Ops::bitAnd(found, both), Ops::andNot(found, candidates));
+            maxHeight = Ops::bitOr(maxHeight, Ops::bitAnd(found, Ops::set(static_cast<uint16_t>(1u << k))));
+        }
+
+        // bumpiness: |h(x) - h(x + 1)| for x < WIDTH - 1, the absolute
+        // value being the two's complement of the negative lanes
+        V right[PLANES];
+        V diff[PLANES];
+        for (int k = 0; k < PLANES; ++k)
+            right[k] = Ops::shiftRight1(heights[k]);
+        V negative = subtract<Ops>(heights, right, diff);
+        V carry = negative;
+        for (int k = 0; k < PLANES; ++k) {
+            V flipped = Ops::bitXor(diff[k], negative);
+            diff[k] = Ops::bitXor(flipped, carry);
+            carry = Ops::bitAnd(flipped, carry);
+        }
+        V bumpiness = weightedCount<Ops>(diff, Ops::set(FULL_ROW >> 1));
+
+        // wells: min(h(x - 1), h(x + 1)) - h(x) where positive, walls at HEIGHT
+        V left[PLANES];
+        V rim[PLANES];
+        for (int k = 0; k < PLANES; ++k) {
+            bool wall = (HEIGHT >> k) & 1;
+            left[k] = Ops::bitAnd(Ops::shiftLeft1(heights[k]), full);
+            if (wall) {
+                left[k] = Ops::bitOr(left[k], Ops::set(1));
+                right[k] = Ops::bitOr(right[k], Ops::set(static_cast<uint16_t>(1u << (WIDTH - 1))));
+            }
+        }
+        V lower = subtract<Ops>(left, right, rim);
+        for (int k = 0; k < PLANES; ++k)
+            rim[k] = Ops::bitOr(Ops::bitAnd(lower, left[k]), Ops::andNot(lower, right[k]));
+        V depth[PLANES];
+        V shallow = subtract<Ops>(rim, heights, depth);
+        V wells = weightedCount<Ops>(depth, Ops::andNot(shallow, full));
+
+        Ops::store(out + AGGREGATE_HEIGHT * Ops::LANES, weightedCount<Ops>(heights, full));
+        Ops::store(out + HOLES * Ops::LANES, holes);
+        Ops::store(out + BUMPINESS * Ops::LANES, bumpiness);
+        Ops::store(out + WELLS * Ops::LANES, wells);
+        Ops::store(out + MAX_HEIGHT * Ops::LANES, maxHeight);
+        Ops::store(out + ROW_TRANSITIONS * Ops::LANES, rowTransitions);
+        Ops::store(out + COLUMN_TRANSITIONS * Ops::LANES, columnTransitions);
+    }
+
+    // 16 boards at a time, in FeatureKernelAvx2.cpp; only call it when the
+    // CPU supports AVX2
+    constexpr int AVX2_LANES = 16;
+    void computeAvx2(const uint16_t *rows, uint16_t *out);
+}
+
+#endif /* _FEATURE_KERNEL_IMPL_ */
@@ -1,275 +1,228 @@
 #include "Game.hpp"
 #include "Renderer.hpp"
-#include <cstdlib>
-#include "Board.hpp"
 #include <ctime>
 #include <SDL2/SDL.h>
 #include <iostream>
-#include "Board.hpp"
 
-Piece::Tetromino Game::getRandomTetromino() {
-    return static_cast<Piece::Tetromino>(rand() % TETROMINO_COUNT);
-}
-
-void Game::initNextPieces() {
-    nextPieces.clear();
-    for (int i = 0; i < NEXT_PIECE_COUNT; i++) {
-        nextPieces.push_back(Piece(getRandomTetromino()));
+namespace {
+    uint64_t makeSeed() {
+        return (static_cast<uint64_t>(std::time(nullptr)) << 32) ^ SDL_GetPerformanceCounter();
     }
 }
 
-void Game::printNextPiece() {
-    std::cout << "Next pieces: ";
-    for (const auto &piece : nextPieces) {
-        std::cout << piece.getType() << " ";
-    }
-    std::cout << std::endl;
-}
-Game::Game() : rendererWrapper(nullptr), window(nullptr), renderer(nullptr), ownsSdlResources(true), 
-             currentPiece(Piece::I), nextPieces() {
+Game::Game() : rendererWrapper(nullptr), window(nullptr), renderer(nullptr),
+             audioManager(AudioManager::getInstance()), ownsSdlResources(true),
+             simulation(makeSeed()), autoPlayer(nullptr), fastReplay(false) {
     SDL_Init(SDL_INIT_VIDEO);
     window = SDL_CreateWindow("Tetris", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIN_WIDTH, WIN_HEIGHT, 0);
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
     rendererWrapper = new Renderer(renderer);
 
-    try {
-        if (!audioManager.init()) {
-            std::cerr << "Warning: failed to init audio!" << std::endl;
-        } else {
-            audioManager.playMusic();
-        }
-        board.setAudioManager(&audioManager);
-    } catch (const std::exception& e) {
-        std::cerr << "Exception during audio initialization: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown exception during audio initialization" << std::endl;
+    initAudio();
+    fellLastTick = false;
+    autoPlayFrames = 0;
+}
+
+// Constructor for menu system
+Game::Game(Renderer* externalRenderer, AutoPlayer *autoPlayer, const std::string &recordPath,
+           const std::string &archivePath)
+           : rendererWrapper(externalRenderer), window(nullptr), renderer(nullptr),
+             audioManager(AudioManager::getInstance()), ownsSdlResources(false),
+             simulation(makeSeed()), autoPlayer(autoPlayer), fastReplay(false) {
+    initAudio();
+    fellLastTick = false;
+    autoPlayFrames = 0;
+    if (!recordPath.empty()) {
+        const Randomizer &randomizer = simulation.getRandomizer();
+        recorder.reset(new ReplayRecorder(recordPath, randomizer.getSeed(), randomizer.getMode()));
     }
+    if (!archivePath.empty())
+        archive.reset(new SessionArchiveWriter(archivePath));
+    if (autoPlayer)
+        autoPlayer->reset();
+}
 
-    std::srand(std::time(nullptr));
-    quit = false;
-    gameOver = false;
-    heldPiece = nullptr;
-    hasHeldPiece = false;
-    canHold = true;
-    initNextPieces();
-    spawnNewPiece();
+// Constructor for replays
+Game::Game(Renderer* externalRenderer, std::unique_ptr<Replay> replay, bool fast) : rendererWrapper(externalRenderer),
+             window(nullptr), renderer(nullptr), audioManager(AudioManager::getInstance()), ownsSdlResources(false),
+             simulation(replay->seed, replay->mode), autoPlayer(nullptr), fastReplay(fast) {
+    initAudio();
+    fellLastTick = false;
+    autoPlayFrames = 0;
+    replayPlayer.reset(new ReplayPlayer(std::move(replay)));
 }
 
-// Constructor for menu system
-Game::Game(Renderer* externalRenderer) : rendererWrapper(externalRenderer), window(nullptr), renderer(nullptr),
-             ownsSdlResources(false), currentPiece(Piece::I), nextPieces() {
-    rendererWrapper = externalRenderer;
-    window = nullptr;
-    renderer = nullptr;
-    
+Game::~Game() {
+    // a game left before the end is still a valid replay up to here
+    if (recorder)
+        recorder->finish(simulation.getTickCount());
+    if (ownsSdlResources) {
+        delete rendererWrapper;
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        audioManager.shutdown();
+        SDL_Quit();
+    }
+}
+
+void Game::initAudio() {
+    // opened by the menu already, init() only does the work for the first game
     try {
         if (!audioManager.init()) {
             std::cerr << "Warning: failed to init audio!" << std::endl;
         } else {
             audioManager.playMusic();
         }
-        board.setAudioManager(&audioManager);
     } catch (const std::exception& e) {
         std::cerr << "Exception during audio initialization: " << e.what() << std::endl;
     } catch (...) {
         std::cerr << "Unknown exception during audio initialization" << std::endl;
     }
+}
 
-    std::srand(std::time(nullptr));
-    quit = false;
-    gameOver = false;
-    heldPiece = nullptr;
-    hasHeldPiece = false;
-    canHold = true;
-    initNextPieces();
-    spawnNewPiece();
+void Game::playEvents(int events) {
+    if (events & Simulation::EVENT_ROTATE)
+        audioManager.playSound(AudioManager::ROTATE);
+    if (events & Simulation::EVENT_PLACE)
+        audioManager.playSound(AudioManager::PLACE);
+    if (events & Simulation::EVENT_LINE_CLEAR)
+        audioManager.playSound(AudioManager::LINE_CLEAR);
+    if (events & Simulation::EVENT_GAME_OVER)
+        audioManager.playSound(AudioManager::GAME_OVER);
 }
 
-Game::~Game() {
-    if (ownsSdlResources) {
-        delete rendererWrapper;
-        SDL_DestroyRenderer(renderer);
-        SDL_DestroyWindow(window);
-        SDL_Quit();
-    }
-    if (heldPiece != nullptr) {
-        delete heldPiece;
-    }
+int Game::play(Simulation::Action action) {
+    if (recorder)
+        recorder->record(simulation.getTickCount(), action);
+    return track(simulation.step(action));
 }
 
-int Game::getDropDelay() const {
-    int level = board.getLevel();
+int Game::track(int events) {
+    if (archive && (events & Simulation::EVENT_PLACE))
+        placements.push_back(SessionArchive::encode(simulation.getLastPlacement()));
+    return events;
+}
 
-    if (level == 0) return 48 * 16; // 48 frames
-    else if (level == 1) return 43 * 16;
-    else if (level == 2) return 38 * 16;
-    else if (level == 3) return 33 * 16;
-    else if (level == 4) return 28 * 16;
-    else if (level == 5) return 23 * 16;
-    else if (level == 6) return 18 * 16;
-    else if (level == 7) return 13 * 16;
-    else if (level == 8) return 8 * 16;
-    else if (level == 9) return 6 * 16;
-    else if (level >= 10 && level <= 12) return 5 * 16;
-    else if (level >= 13 && level <= 15) return 4 * 16;
-    else if (level >= 16 && level <= 18) return 3 * 16;
-    else if (level >= 19 && level <= 28) return 2 * 16;
-    else return 16; // 1 frame (level 29+)
+void Game::finishGame() {
+    if (!simulation.isGameOver())
+        return;
+    if (recorder)
+        recorder->finish(simulation.getTickCount());
+    if (archive) {
+        archive->append(simulation, placements);
+        archive.reset();
+    }
 }
 
 void Game::update() {
-    static Uint32 lastTick = SDL_GetTicks();
-    int dropDelay = getDropDelay();
-    
-    if (SDL_GetTicks() - lastTick > static_cast<Uint32>(dropDelay)) {
-        if (board.isValidPosition(currentPiece, pieceX, pieceY + 1)) {
-            pieceY++;
-        } else {
-            board.placePiece(currentPiece, pieceX, pieceY);
-            try {
-                audioManager.playSound(AudioManager::PLACE);
-            } catch (...) {
-                std::cerr << "Warning: Exception when playing place sound" << std::endl;
-            }
-            spawnNewPiece();
+    // takes effect when the current track ends
+    audioManager.setMusicLevel(simulation.getBoard().getLevel());
+
+    if (replayPlayer) {
+        if (fastReplay) {
+            // as many ticks as fit in the budget, sounds would only be noise
+            Uint64 frequency = SDL_GetPerformanceFrequency();
+            Uint64 start = SDL_GetPerformanceCounter();
+            while (!replayPlayer->isFinished(simulation) &&
+                   (SDL_GetPerformanceCounter() - start) * 1000000 < REPLAY_FAST_MICROS * frequency)
+                replayPlayer->advance(simulation);
+            fellLastTick = false;
+            return;
         }
-        lastTick = SDL_GetTicks();
+        int pieceCount = simulation.getPieceCount();
+        int pieceY = simulation.getPieceY();
+        playEvents(replayPlayer->advance(simulation));
+        fellLastTick = simulation.getPieceCount() == pieceCount && simulation.getPieceY() == pieceY + 1;
+        return;
     }
-}
 
-void Game::render() {
-    rendererWrapper->drawBoard(board, currentPiece, pieceX, pieceY, nextPieces, heldPiece);
-}
+    // only a player can rewind, the demo has no use for snapshots
+    if (!autoPlayer)
+        timeline.capture(simulation);
 
-void Game::spawnNewPiece() {
-    pieceX = (Board::WIDTH / 2) - 2;
-    pieceY = 0;
-    
-    currentPiece = nextPieces[0];
-    
-    for (int i = 0; i < NEXT_PIECE_COUNT - 1; i++) {
-        nextPieces[i] = nextPieces[i + 1];
+    // the autoplayer presses one key every AUTO_PLAY_FRAMES ticks
+    if (autoPlayer && ++autoPlayFrames >= AUTO_PLAY_FRAMES) {
+        autoPlayFrames = 0;
+        playEvents(play(autoPlayer->chooseAction(simulation)));
     }
-    
-    // nextPieces[NEXT_PIECE_COUNT - 1] = Piece::I;
-    nextPieces[NEXT_PIECE_COUNT - 1] = Piece(getRandomTetromino());
-    
-    canHold = true;
-    
-    // printNextPiece();
-    if (!board.isValidPosition(currentPiece, pieceX, pieceY)) {
-        quit = true;
-        gameOver = true;
-        audioManager.playSound(AudioManager::GAME_OVER);
+
+    int pieceCount = simulation.getPieceCount();
+    int pieceY = simulation.getPieceY();
+
+    playEvents(track(simulation.tick()));
+    fellLastTick = simulation.getPieceCount() == pieceCount && simulation.getPieceY() == pieceY + 1;
+    finishGame();
+}
+
+bool Game::render(float alpha, bool force) {
+    // draw the falling piece between its previous and current row
+    float fallOffset = fellLastTick ? alpha - 1.0f : 0.0f;
+
+    bool drawn = rendererWrapper->drawBoard(simulation, fallOffset, force);
+    if (drawn && ownsSdlResources) {
+        SDL_RenderPresent(renderer);
     }
+    return drawn;
 }
 
-void Game::holdPiece() {
-    if (!canHold) {
+void Game::handleInputEvent(SDL_Event &e) {
+    if (e.type == SDL_KEYDOWN && replayPlayer) {
+        // scrub through the replay
+        uint64_t tick = simulation.getTickCount();
+        if (e.key.keysym.sym == SDLK_LEFT)
+            replayPlayer->seek(simulation, tick > REPLAY_SEEK_TICKS ? tick - REPLAY_SEEK_TICKS : 0);
+        else if (e.key.keysym.sym == SDLK_RIGHT)
+            replayPlayer->seek(simulation, tick + REPLAY_SEEK_TICKS);
+        fellLastTick = false;
         return;
     }
-    
-    if (heldPiece == nullptr) {
-        heldPiece = new Piece(currentPiece);
-        hasHeldPiece = true;
-        spawnNewPiece();
-    } else {
-        Piece tempPiece = currentPiece;
-        currentPiece = *heldPiece;
-        delete heldPiece;
-        heldPiece = new Piece(tempPiece);
-        
-        pieceX = (Board::WIDTH / 2) - 2;
-        pieceY = 0;
-        
-        if (!board.isValidPosition(currentPiece, pieceX, pieceY)) {
-            quit = true;
-            gameOver = true;
-        }
+    if (e.type != SDL_KEYDOWN || autoPlayer)
+        return;
+    if (e.key.keysym.sym == SDLK_BACKSPACE) {
+        rewind();
+        return;
     }
-    
-    canHold = false;
-}
 
-void Game::handleInputEvent(SDL_Event &e) {
-    if (e.type == SDL_KEYDOWN) {
-        switch (e.key.keysym.sym) {
-            case SDLK_LEFT:
-                if (board.isValidPosition(currentPiece, pieceX - 1, pieceY))
-                    pieceX--;
-                break;
-            case SDLK_RIGHT:
-                if (board.isValidPosition(currentPiece, pieceX + 1, pieceY))
-                    pieceX++;
-                break;
-            case SDLK_DOWN:
-                if (board.isValidPosition(currentPiece, pieceX, pieceY + 1))
-                    pieceY++;
-                board.setScore(board.getScore() + 1);
-                break;
-            case SDLK_UP:
-                {
-                    Piece tempPiece = currentPiece;
-                    
-                    currentPiece.rotate();
-                    if (!board.isValidPosition(currentPiece, pieceX, pieceY)) {
-                        if (!tryWallKicks()) {
-                            currentPiece = tempPiece;
-                        } else {
-                            audioManager.playSound(AudioManager::ROTATE);
-                        }
-                    } else {
-                        audioManager.playSound(AudioManager::ROTATE);
-                    }
-                }
-                break;
-            case SDLK_SPACE:
-                {
-                    int dropY = board.findDropPosition(currentPiece, pieceX, pieceY);
-                    if (board.isValidPosition(currentPiece, pieceX, dropY)) {
-                        pieceY = dropY;
-                        board.placePiece(currentPiece, pieceX, pieceY);
-                        spawnNewPiece();
-                    }
-                }
-                break;
-            case SDLK_RSHIFT:
-                if (canHold) {
-                    holdPiece();
-                }
-                break;
-            default:
-                break;
-        }
+    Simulation::Action action = Simulation::NONE;
+    switch (e.key.keysym.sym) {
+        case SDLK_LEFT:   action = Simulation::MOVE_LEFT;  break;
+        case SDLK_RIGHT:  action = Simulation::MOVE_RIGHT; break;
+        case SDLK_DOWN:   action = Simulation::SOFT_DROP;  break;
+        case SDLK_UP:     action = Simulation::ROTATE;     break;
+        case SDLK_SPACE:  action = Simulation::HARD_DROP;  break;
+        case SDLK_RSHIFT: action = Simulation::HOLD;       break;
+        default:
+            break;
+    }
+    if (action != Simulation::NONE) {
+        playEvents(play(action));
+        fellLastTick = false;
+        finishGame();
     }
 }
 
-bool Game::isGameOver() const {
-    return gameOver;
-}
+void Game::rewind() {
+    uint64_t tick = simulation.getTickCount();
+    const Simulation::Snapshot *saved = timeline.find(tick > REPLAY_SEEK_TICKS ? tick - REPLAY_SEEK_TICKS : 0);
+    if (!saved)
+        saved = timeline.getOldest();
+    if (!saved)
+        return;
 
-bool Game::tryWallKicks() {
-    // define tout les offests de wall kicks
-    const std::pair<int, int> kicks[] = {
-        {-1, 0},  // gauche
-        {1, 0},   // droite
-        {-2, 0},  // 2 a gauche
-        {2, 0},   // 2 a droite
-        {0, -1},  // en haut
-        {0, 1},   // en bas
-        {-1, -1}, // en haut a gauche
-        {1, -1}   // en haut a droite
-    };
+    // From here the game is no longer the one its inputs describe: the
+    // replay ends where the rewind happened (it still plays back up to
+    // there) and the game is not archived, its stats would be made up.
+    if (recorder)
+        recorder->finish(tick);
+    archive.reset();
+    placements.clear();
+
+    simulation.restore(*saved);
+    timeline.discardAfter(saved->tickCount);
+    fellLastTick = false;
+}
 
-    for (size_t i = 0; i < sizeof(kicks) / sizeof(kicks[0]); ++i) {
-        int xOffset = kicks[i].first;
-        int yOffset = kicks[i].second;
-        if (board.isValidPosition(currentPiece, pieceX + xOffset, pieceY + yOffset)) {
-            pieceX += xOffset;
-            pieceY += yOffset;
-            return true;
-        }
-    }
-    // pas de position valide
-    return false;
+bool Game::isGameOver() const {
+    // a replay that stops before the game did ends there too
+    return simulation.isGameOver() || (replayPlayer && replayPlayer->isFinished(simulation));
 }
@@ -1,28 +1,47 @@
 #ifndef _GAME_
     #define _GAME_
 #include <SDL2/SDL.h>
-#include "Board.hpp"
-#include "Piece.hpp"
+#include "Simulation.hpp"
+#include "AutoPlayer.hpp"
 #include "AudioManager.hpp"
-#include <vector>
+#include "Replay.hpp"
+#include "SessionArchive.hpp"
+#include <memory>
+#include <string>
 #define WIN_HEIGHT  1080
 #define WIN_WIDTH   1920
 #define WAIT_TIME   500
-#define NEXT_PIECE_COUNT 4
+// ticks between two inputs of the autoplayer, slow enough to follow
+#define AUTO_PLAY_FRAMES 4
+// time a fast replay may simulate per update, leaves room to render
+#define REPLAY_FAST_MICROS 8000
+// ticks skipped by one press of left / right during a replay, or taken
+// back by backspace in a live game (10 s at 60 Hz)
+#define REPLAY_SEEK_TICKS 600
 
 class Renderer;
 
 class Game {
     public:
         Game();
-        Game(Renderer* externalRenderer);
+        // autoPlayer: plays the game and keyboard game inputs are ignored,
+        // nullptr for a human player; owned by the caller, who can reuse it;
+        // recordPath: where the game is recorded, empty for no replay;
+        // archivePath: session archive the game is added to once over, empty for none
+        Game(Renderer* externalRenderer, AutoPlayer *autoPlayer = nullptr, const std::string &recordPath = "",
+             const std::string &archivePath = "");
+        // plays a recorded game back, in real time or as fast as possible
+        Game(Renderer* externalRenderer, std::unique_ptr<Replay> replay, bool fast);
         ~Game();
         
         // Menu system interface
-        void update();
-        void render();
+        void update();      // advances the simulation by one fixed tick
+        // returns false when nothing changed since the last frame (unless forced)
+        bool render(float alpha = 1.0f, bool force = false);
         void handleInputEvent(SDL_Event &e);
         bool isGameOver() const;
+        bool isAutoPlaying() const { return autoPlayer != nullptr; }
+        bool isReplaying() const { return replayPlayer != nullptr; }
         
         // void run();
 
@@ -30,28 +49,38 @@ class Game {
         Renderer *rendererWrapper;
         SDL_Window *window;
         SDL_Renderer *renderer;
-        AudioManager audioManager;
+        // shared with the menu and every other game
+        AudioManager &audioManager;
         bool ownsSdlResources;
 
-        Board board;
-        Piece currentPiece;
-        std::vector<Piece> nextPieces;
-        Piece* heldPiece;
-        bool hasHeldPiece;
-        bool canHold;
-        int pieceX, pieceY;
-
-        bool quit;
-        bool gameOver;
-
-        void handleInput();
-        void spawnNewPiece();
-        void holdPiece();
-        bool tryWallKicks();
-        Piece::Tetromino getRandomTetromino();
-        void initNextPieces();
-        void printNextPiece();
-        int getDropDelay() const;
+        Simulation simulation;
+        // set when the last tick moved the piece down one row by gravity,
+        // so render() can slide it between the two rows
+        bool fellLastTick;
+
+        AutoPlayer *autoPlayer;
+        int autoPlayFrames;
+
+        std::unique_ptr<ReplayRecorder> recorder;
+        std::unique_ptr<ReplayPlayer> replayPlayer;
+        bool fastReplay;
+
+        std::unique_ptr<SessionArchiveWriter> archive;
+        // every piece locked so far, for the archive
+        std::vector<uint16_t> placements;
+        // snapshots of a live game to rewind to (a replay keeps its own)
+        Timeline timeline;
+
+        void initAudio();
+        void playEvents(int events);
+        // step() that also goes to the replay being recorded
+        int play(Simulation::Action action);
+        // notes the piece locked by events, if any
+        int track(int events);
+        // closes the replay and archives the game once it is over
+        void finishGame();
+        // back to the snapshot at least REPLAY_SEEK_TICKS ago, or the oldest one
+        void rewind();
 };
 
 #endif /* _GAME_ */
@@ -0,0 +1,178 @@
+#include "GlyphAtlas.hpp"
+#include <cstdio>
+
+GlyphAtlas::GlyphAtlas(SDL_Renderer *r, const char *path) : renderer(r), fontPath(path ? path : "") {}
+
+GlyphAtlas::~GlyphAtlas() {
+    for (auto &pair : faces) {
+        if (pair.second.texture)
+            SDL_DestroyTexture(pair.second.texture);
+    }
+    for (auto &pair : strings) {
+        if (pair.second.texture)
+            SDL_DestroyTexture(pair.second.texture);
+    }
+    for (auto &pair : fonts) {
+        if (pair.second)
+            TTF_CloseFont(pair.second);
+    }
+}
+
+void GlyphAtlas::setFontData(std::vector<uint8_t> data) {
+    if (fonts.empty())
+        fontData = std::move(data);
+}
+
+TTF_Font *GlyphAtlas::getFont(int fontSize) {
+    auto it = fonts.find(fontSize);
+    if (it != fonts.end())
+        return it->second;
+
+    // a failed open is cached too so we don't retry every frame
+    TTF_Font *font = fontData.empty()
+        ? TTF_OpenFont(fontPath.c_str(), fontSize)
+        : TTF_OpenFontRW(SDL_RWFromConstMem(fontData.data(), static_cast<int>(fontData.size())), 1, fontSize);
+    if (!font) {
+        printf("Failed to load font with size %d! SDL_ttf Error: %s\n", fontSize, TTF_GetError());
+    }
+    fonts[fontSize] = font;
+    return font;
+}
+
+const GlyphAtlas::Face *GlyphAtlas::getFace(int fontSize) {
+    auto it = faces.find(fontSize);
+    if (it != faces.end())
+        return it->second.texture ? &it->second : nullptr;
+
+    Face &face = faces[fontSize];
+    face.texture = nullptr;
+    TTF_Font *font = getFont(fontSize);
+    if (!font)
+        return nullptr;
+
+    // rasterize every glyph, shelf-packing them into rows of the atlas
+    SDL_Color white = { 255, 255, 255, 255 };
+    std::array<SDL_Surface *, GLYPH_COUNT> rendered;
+    int penX = 0, penY = 0;
+    face.height = TTF_FontHeight(font);
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        char text[2] = { static_cast<char>(FIRST_GLYPH + i), '\0' };
+        rendered[i] = TTF_RenderText_Solid(font, text, white);
+        int width = rendered[i] ? rendered[i]->w : 0;
+        if (penX + width > ATLAS_WIDTH) {
+            penX = 0;
+            penY += face.height;
+        }
+        face.glyphs[i] = { penX, penY, width, face.height };
+        penX += width;
+    }
+
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, penY + face.height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (atlas) {
+        SDL_FillRect(atlas, NULL, 0);
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            if (rendered[i])
+                SDL_BlitSurface(rendered[i], NULL, atlas, &face.glyphs[i]);
+        }
+        face.texture = SDL_CreateTextureFromSurface(renderer, atlas);
+        if (face.texture) {
+            SDL_SetTextureBlendMode(face.texture, SDL_BLENDMODE_BLEND);
+        } else {
+            printf("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+        }
+        SDL_FreeSurface(atlas);
+    }
+    for (SDL_Surface *surface : rendered) {
+        if (surface)
+            SDL_FreeSurface(surface);
+    }
+    return face.texture ? &face : nullptr;
+}
+
+const GlyphAtlas::CachedString *GlyphAtlas::getString(const char *text, int fontSize) {
+    std::string key = std::to_string(fontSize) + ':' + text;
+    auto it = strings.find(key);
+    if (it != strings.end())
+        return it->second.texture ? &it->second : nullptr;
+
+    CachedString &cached = strings[key];
+    cached.texture = nullptr;
+    TTF_Font *font = getFont(fontSize);
+    if (!font)
+        return nullptr;
+
+    SDL_Surface *surface = TTF_RenderText_Solid(font, text, SDL_Color{ 255, 255, 255, 255 });
+    if (!surface) {
+        printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
+        return nullptr;
+    }
+    cached.texture = SDL_CreateTextureFromSurface(renderer, surface);
+    cached.width = surface->w;
+    cached.height = surface->h;
+    SDL_FreeSurface(surface);
+    if (!cached.texture) {
+        printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+        return nullptr;
+    }
+    return &cached;
+}
+
+bool GlyphAtlas::measure(const char *text, int fontSize, int &width, int &height) {
+    // font still loading: no failure is cached, the next frame tries again
+    if (fontData.empty() && fontPath.empty())
+        return false;
+    if (fontSize > ATLAS_MAX_FONT_SIZE) {
+        const CachedString *cached = getString(text, fontSize);
+        if (!cached)
+            return false;
+        width = cached->width;
+        height = cached->height;
+        return true;
+    }
+
+    const Face *face = getFace(fontSize);
+    if (!face)
+        return false;
+    width = 0;
+    for (const char *c = text; *c; ++c) {
+        if (*c >= FIRST_GLYPH && *c <= LAST_GLYPH)
+            width += face->glyphs[*c - FIRST_GLYPH].w;
+    }
+    height = face->height;
+    return true;
+}
+
+void GlyphAtlas::draw(const char *text, int fontSize, SDL_Rect destRect, SDL_Color color) {
+    int width, height;
+    if (!measure(text, fontSize, width, height) || width == 0)
+        return;
+
+    bool natural = destRect.w == 0 || destRect.h == 0;
+    float scaleX = natural ? 1.0f : static_cast<float>(destRect.w) / width;
+    float scaleY = natural ? 1.0f : static_cast<float>(destRect.h) / height;
+
+    if (fontSize > ATLAS_MAX_FONT_SIZE) {
+        const CachedString *cached = getString(text, fontSize);
+        SDL_SetTextureColorMod(cached->texture, color.r, color.g, color.b);
+        SDL_Rect dest = { destRect.x, destRect.y, natural ? width : destRect.w, natural ? height : destRect.h };
+        SDL_RenderCopy(renderer, cached->texture, NULL, &dest);
+        return;
+    }
+
+    const Face *face = getFace(fontSize);
+    SDL_SetTextureColorMod(face->texture, color.r, color.g, color.b);
+    int penX = 0;
+    for (const char *c = text; *c; ++c) {
+        if (*c < FIRST_GLYPH || *c > LAST_GLYPH)
+            continue;
+        const SDL_Rect &source = face->glyphs[*c - FIRST_GLYPH];
+        SDL_Rect dest = {
+            destRect.x + static_cast<int>(penX * scaleX),
+            destRect.y,
+            static_cast<int>((penX + source.w) * scaleX) - static_cast<int>(penX * scaleX),
+            static_cast<int>(source.h * scaleY)
+        };
+        SDL_RenderCopy(renderer, face->texture, &source, &dest);
+        penX += source.w;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef _GLYPH_ATLAS_
+#define _GLYPH_ATLAS_
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Text drawing without per-frame font or texture work. For each font size
+// the printable ASCII glyphs are rasterized once, in white, into a single
+// texture; a string is then one SDL_RenderCopy per character, tinted with
+// the texture colour mod. Sizes too large for a sensible atlas (titles)
+// cache one texture per distinct string instead.
+//
+// The font is opened from the file, or from data read beforehand (off the
+// main thread at startup, see AssetManager). Until either is there nothing
+// is drawn and nothing is cached.
+class GlyphAtlas {
+    public:
+        static constexpr int ATLAS_MAX_FONT_SIZE = 64;
+
+        // fontPath may be null when the data comes later through setFontData()
+        GlyphAtlas(SDL_Renderer *r, const char *fontPath);
+        ~GlyphAtlas();
+
+        GlyphAtlas(const GlyphAtlas &) = delete;
+        GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+        // size of the text as draw() lays it out: the sum of the glyph
+        // advances, without kerning, so it can be a few pixels off
+        // TTF_SizeText (sizes above ATLAS_MAX_FONT_SIZE use the rendered string)
+        bool measure(const char *text, int fontSize, int &width, int &height);
+        // draws text into destRect; a zero width or height keeps the natural size
+        void draw(const char *text, int fontSize, SDL_Rect destRect, SDL_Color color);
+        // the whole font file; every size is opened from this one copy.
+        // Ignored once a size has been opened.
+        void setFontData(std::vector<uint8_t> data);
+
+    private:
+        static constexpr char FIRST_GLYPH = ' ';
+        static constexpr char LAST_GLYPH = '~';
+        static constexpr int GLYPH_COUNT = LAST_GLYPH - FIRST_GLYPH + 1;
+        static constexpr int ATLAS_WIDTH = 1024;
+
+        struct Face {
+            SDL_Texture *texture;
+            std::array<SDL_Rect, GLYPH_COUNT> glyphs;   // source rect, w is also the advance
+            int height;
+        };
+
+        struct CachedString {
+            SDL_Texture *texture;
+            int width;
+            int height;
+        };
+
+        SDL_Renderer *renderer;
+        std::string fontPath;
+        std::vector<uint8_t> fontData;
+        std::unordered_map<int, TTF_Font *> fonts;
+        std::unordered_map<int, Face> faces;
+        std::unordered_map<std::string, CachedString> strings;
+
+        TTF_Font *getFont(int fontSize);
+        const Face *getFace(int fontSize);
+        const CachedString *getString(const char *text, int fontSize);
+};
+
+#endif /* _GLYPH_ATLAS_ */
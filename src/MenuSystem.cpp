@@ -1,40 +1,86 @@
 #include "MenuSystem.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 #define WIN_HEIGHT  1080
 #define WIN_WIDTH   1920
 
-MenuSystem::MenuSystem() : game(nullptr), currentState(START_MENU), quit(false) {
+MenuSystem::MenuSystem(int tickRate, bool vsync) : game(nullptr), audioManager(AudioManager::getInstance()),
+             currentState(START_MENU), quit(false),
+             tickRate(tickRate > 0 ? tickRate : DEFAULT_TICK_RATE) {
     SDL_Init(SDL_INIT_VIDEO);
+    // font and audio load on worker threads while the window opens, the
+    // menu shows up without waiting for them (see pollAssets)
+    assets.load(FONT_PATH, audioManager);
     window = SDL_CreateWindow("Tetris", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIN_WIDTH, WIN_HEIGHT, 0);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    rendererWrapper = new Renderer(renderer);
-
-    if (!audioManager.init()) {
-        std::cerr << "Warning: failed to init audio!" << std::endl;
-    } else {
-        audioManager.playMusic();
-    }
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
+    rendererWrapper = new Renderer(renderer, nullptr);
+    assets.markWindow();
 }
 
 MenuSystem::~MenuSystem() {
+    // audio must be fully up before it can be shut down
+    assets.wait();
     if (game) {
         delete game;
     }
     delete rendererWrapper;
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
+    audioManager.shutdown();
     SDL_Quit();
 }
 
 void MenuSystem::run() {
+    // fixed timestep: the simulation advances in whole ticks whatever the
+    // render rate, the leftover fraction is used to interpolate the frame
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 tickLength = frequency / tickRate;
+    // never try to catch up more than a quarter second after a stall
+    const Uint64 maxFrameTime = frequency / 4;
+    Uint64 previous = SDL_GetPerformanceCounter();
+    Uint64 accumulator = 0;
+
     while (!quit) {
+        Uint64 now = SDL_GetPerformanceCounter();
+        accumulator += std::min(now - previous, maxFrameTime);
+        previous = now;
+
+        pollAssets();
         handleInput();
         if (quit)
             break;
-        update();
-        render();
-        SDL_Delay(16); // ~60 FPS
+        while (accumulator >= tickLength) {
+            update();
+            accumulator -= tickLength;
+        }
+        if (!render(static_cast<float>(accumulator) / tickLength)) {
+            // nothing presented, so no vsync wait either: don't spin
+            SDL_Delay(1);
+        }
+    }
+}
+
+void MenuSystem::pollAssets() {
+    if (startupReported)
+        return;
+    int loaded = assets.poll();
+    if (loaded & AssetManager::LOADED_FONT) {
+        rendererWrapper->setFontData(assets.takeFontData());
+        // buttons were laid out without text
+        forceRedraw = true;
+    }
+    if (loaded & AssetManager::LOADED_AUDIO) {
+        if (!assets.isAudioReady())
+            std::cerr << "Warning: failed to init audio!" << std::endl;
+        else if (currentState != PAUSED)
+            audioManager.playMusic();
+    }
+    if (assets.isDone()) {
+        assets.report(std::cout);
+        startupReported = true;
     }
 }
 
@@ -44,6 +90,8 @@ void MenuSystem::handleInput() {
     if (currentState == START_MENU) {
         isStartButtonHovered = (mouseX >= startButtonRect.x && mouseX <= startButtonRect.x + startButtonRect.w &&
             mouseY >= startButtonRect.y && mouseY <= startButtonRect.y + startButtonRect.h);
+        isDemoButtonHovered = (mouseX >= demoButtonRect.x && mouseX <= demoButtonRect.x + demoButtonRect.w &&
+            mouseY >= demoButtonRect.y && mouseY <= demoButtonRect.y + demoButtonRect.h);
         isQuitButtonHovered = (mouseX >= quitButtonRect.x && mouseX <= quitButtonRect.x + quitButtonRect.w &&
             mouseY >= quitButtonRect.y && mouseY <= quitButtonRect.y + quitButtonRect.h);
     }
@@ -53,6 +101,14 @@ void MenuSystem::handleInput() {
             quit = true;
             return;
         }
+        if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+            // cached layers live in render targets that the driver just dropped
+            rendererWrapper->invalidateLayers();
+            forceRedraw = true;
+        } else if (e.type == SDL_WINDOWEVENT) {
+            // the window contents may have been lost, draw the next frame in full
+            forceRedraw = true;
+        }
 
         switch (currentState) {
             case START_MENU:
@@ -77,6 +133,13 @@ void MenuSystem::handleStartMenuInput(SDL_Event &e) {
             case SDLK_ESCAPE:
                 quit = true;
                 return;
+            // replays the last game, F as fast as possible
+            case SDLK_l:
+                startReplay(LAST_REPLAY_PATH, false);
+                break;
+            case SDLK_f:
+                startReplay(LAST_REPLAY_PATH, true);
+                break;
             default:
                 break;
         }
@@ -89,6 +152,10 @@ void MenuSystem::handleStartMenuInput(SDL_Event &e) {
                 mouseY >= startButtonRect.y && mouseY <= startButtonRect.y + startButtonRect.h) {
                 startNewGame();
             }
+            else if (mouseX >= demoButtonRect.x && mouseX <= demoButtonRect.x + demoButtonRect.w &&
+                     mouseY >= demoButtonRect.y && mouseY <= demoButtonRect.y + demoButtonRect.h) {
+                startNewGame(true);
+            }
             else if (mouseX >= quitButtonRect.x && mouseX <= quitButtonRect.x + quitButtonRect.w &&
                      mouseY >= quitButtonRect.y && mouseY <= quitButtonRect.y + quitButtonRect.h) {
                 quit = true;
@@ -134,7 +201,7 @@ void MenuSystem::handleGameOverInput(SDL_Event &e) {
     if (e.type == SDL_KEYDOWN) {
         switch (e.key.keysym.sym) {
             case SDLK_r:
-                startNewGame();
+                startNewGame(demoMode);
                 break;
             case SDLK_ESCAPE:
                 resetToMenu();
@@ -144,54 +211,75 @@ void MenuSystem::handleGameOverInput(SDL_Event &e) {
 }
 
 void MenuSystem::update() {
+    if (pendingReplay.valid() && pendingReplay.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        std::unique_ptr<Replay> replay = pendingReplay.get();
+        if (replay) {
+            if (game)
+                delete game;
+            demoMode = false;
+            game = new Game(rendererWrapper, std::move(replay), pendingReplayFast);
+            currentState = PLAYING;
+            forceRedraw = true;
+        }
+    }
     if (currentState == PLAYING && game) {
         game->update();
         if (game->isGameOver()) {
-            currentState = GAME_OVER;
+            if (demoMode) {
+                // the demo loops forever
+                startNewGame(true);
+            } else {
+                currentState = GAME_OVER;
+            }
         }
     }
 }
 
-void MenuSystem::render() {
-    // les deux lignes suivantes sont pour éviter de redessiner l'écran
-    // si l'état n'a pas changé, on ne dedraw pas l'écran
-    // sinon l'écran clignote et c'est moche
-    static bool hasRenderedStaticScreen = false;
-    bool isStaticState = (currentState == PAUSED || currentState == GAME_OVER);
+bool MenuSystem::render(float alpha) {
+    // only what changed is redrawn: the game reports whether its
+    // scene moved, menus and overlays are drawn once per state or hover change
+    bool stateChanged = forceRedraw || currentState != lastRenderedState;
+    bool drawn = false;
 
-    if (!isStaticState || !hasRenderedStaticScreen) {
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
-
-        switch (currentState) {
-            case START_MENU:
+    switch (currentState) {
+        case START_MENU:
+            if (stateChanged || isStartButtonHovered != wasStartButtonHovered ||
+                isDemoButtonHovered != wasDemoButtonHovered || isQuitButtonHovered != wasQuitButtonHovered) {
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
                 renderStartMenu();
-                hasRenderedStaticScreen = false;
-                break;
-            case PLAYING:
-                if (game) {
-                    game->render();
-                }
-                hasRenderedStaticScreen = false;
-                break;
-            case PAUSED:
-                if (game) {
-                    game->render();
-                }
+                drawn = true;
+            }
+            break;
+        case PLAYING:
+            drawn = game && game->render(alpha, stateChanged);
+            break;
+        case PAUSED:
+            if (stateChanged && game) {
+                game->render(alpha, true);
                 renderPausedMenu();
-                hasRenderedStaticScreen = true;
-                break;
-            case GAME_OVER:
-                if (game) {
-                    game->render();
-                }
+                drawn = true;
+            }
+            break;
+        case GAME_OVER:
+            if (stateChanged && game) {
+                game->render(alpha, true);
                 renderGameOverMenu();
-                hasRenderedStaticScreen = true;
-                break;
-        }
+                drawn = true;
+            }
+            break;
+    }
 
+    if (drawn) {
         SDL_RenderPresent(renderer);
+        assets.markFirstFrame();
+        lastRenderedState = currentState;
+        wasStartButtonHovered = isStartButtonHovered;
+        wasDemoButtonHovered = isDemoButtonHovered;
+        wasQuitButtonHovered = isQuitButtonHovered;
+        forceRedraw = false;
     }
+    return drawn;
 }
 
 void MenuSystem::renderStartMenu() {
@@ -199,33 +287,41 @@ void MenuSystem::renderStartMenu() {
     SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
 
     // Calculate button sizes for menu options
-    TTF_Font* menuFont = TTF_OpenFont(FONT_PATH, 40);
-    int startWidth, startHeight;
-    TTF_SizeText(menuFont, "Start Game", &startWidth, &startHeight);
+    int startWidth = 0, startHeight = 0;
+    rendererWrapper->measureText("Start Game", 40, startWidth, startHeight);
     
-    int quitWidth, quitHeight;
-    TTF_SizeText(menuFont, "Quit", &quitWidth, &quitHeight);
-    TTF_CloseFont(menuFont);
+    int demoWidth = 0, demoHeight = 0;
+    rendererWrapper->measureText("Demo", 40, demoWidth, demoHeight);
+
+    int quitWidth = 0, quitHeight = 0;
+    rendererWrapper->measureText("Quit", 40, quitWidth, quitHeight);
     
     // Calculate button rectangles
     startButtonRect = {
         windowWidth / 2 - startWidth / 2 - 10,
-        windowHeight / 2 - 50 - startHeight / 2 - 10,
+        windowHeight / 2 - 80 - startHeight / 2 - 10,
         startWidth + 20,
         startHeight + 20
     };
+
+    demoButtonRect = {
+        windowWidth / 2 - demoWidth / 2 - 10,
+        windowHeight / 2 - demoHeight / 2 - 10,
+        demoWidth + 20,
+        demoHeight + 20
+    };
     
     quitButtonRect = {
         windowWidth / 2 - quitWidth / 2 - 10,
-        windowHeight / 2 + 50 - quitHeight / 2 - 10,
+        windowHeight / 2 + 80 - quitHeight / 2 - 10,
         quitWidth + 20,
         quitHeight + 20
     };
     
     // Use renderer to draw the menu
     rendererWrapper->drawMainMenu(windowWidth, windowHeight, 
-                                startButtonRect, quitButtonRect, 
-                                isStartButtonHovered, isQuitButtonHovered);
+                                startButtonRect, demoButtonRect, quitButtonRect,
+                                isStartButtonHovered, isDemoButtonHovered, isQuitButtonHovered);
 }
 
 void MenuSystem::renderPausedMenu() {
@@ -240,15 +336,36 @@ void MenuSystem::renderGameOverMenu() {
     rendererWrapper->drawGameOverMenu(windowWidth, windowHeight);
 }
 
-void MenuSystem::startNewGame() {
+void MenuSystem::startNewGame(bool demo) {
     if (game) {
         delete game;
     }
-    game = new Game(rendererWrapper);
+    demoMode = demo;
+    if (demo && !demoPlayer) {
+        // plan() runs on the render thread once per piece: the deadline
+        // bounds that stall to half a 60 Hz frame. Two search threads are
+        // plenty for the demo and leave the other cores alone.
+        BeamSearch::Settings settings;
+        settings.deadlineMicros = 8000;
+        settings.threads = 2;
+        std::unique_ptr<BeamSearch> planner(new BeamSearch(Evaluator(), settings));
+        demoPlayer.reset(new AutoPlayer(std::move(planner)));
+    }
+    // the demo loops forever, only real games are worth a replay
+    game = new Game(rendererWrapper, demo ? demoPlayer.get() : nullptr, demo ? "" : LAST_REPLAY_PATH,
+                    demo ? "" : SESSION_ARCHIVE_PATH);
     currentState = PLAYING;
     render();
 }
 
+void MenuSystem::startReplay(const std::string &path, bool fast) {
+    // the file is read off the render thread, the menu keeps running meanwhile
+    if (pendingReplay.valid())
+        return;
+    pendingReplay = Replay::loadAsync(path);
+    pendingReplayFast = fast;
+}
+
 void MenuSystem::pauseGame() {
     if (currentState == PLAYING) {
         currentState = PAUSED;
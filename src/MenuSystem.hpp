@@ -4,7 +4,12 @@
 #include <SDL2/SDL.h>
 #include "Game.hpp"
 #include "Renderer.hpp"
+#include "AssetManager.hpp"
 #include "AudioManager.hpp"
+#include "Replay.hpp"
+#include <future>
+#include <memory>
+#include <string>
 
 class MenuSystem {
 public:
@@ -15,29 +20,60 @@ public:
         GAME_OVER
     };
 
-    MenuSystem();
+    // tickRate: fixed simulation steps per second, vsync: present at the
+    // display refresh rate instead of rendering as fast as possible
+    MenuSystem(int tickRate = DEFAULT_TICK_RATE, bool vsync = true);
     ~MenuSystem();
     void run();
+    // loads a replay in the background and plays it once it is ready
+    void startReplay(const std::string &path, bool fast);
+
+    static constexpr int DEFAULT_TICK_RATE = 60;
+    // every game played from the menu is recorded there (L in the menu plays it back)
+    static constexpr const char *LAST_REPLAY_PATH = "last_game.trp";
+    // every finished game is appended there (see SessionArchive)
+    static constexpr const char *SESSION_ARCHIVE_PATH = "sessions.tsa";
 
 private:
+    // first member: startup is timed from its construction
+    AssetManager assets;
+    bool startupReported = false;
     SDL_Window *window;
     SDL_Renderer *renderer;
     Renderer *rendererWrapper;
     Game *game;
-    AudioManager audioManager;
+    AudioManager &audioManager;
 
     State currentState;
     bool quit;
+    int tickRate;
 
     SDL_Rect startButtonRect;
+    SDL_Rect demoButtonRect;
     SDL_Rect quitButtonRect;
     bool isStartButtonHovered = false;
+    bool isDemoButtonHovered = false;
     bool isQuitButtonHovered = false;
-    bool hasRenderedStaticScreen = false;
+    // the current game is played by the autoplayer, restarted when it tops out
+    bool demoMode = false;
+    // built on the first demo and kept for every demo after it: its search
+    // threads and score cache are set up once
+    std::unique_ptr<AutoPlayer> demoPlayer;
+    // replay being read from disk, played by update() when it is in
+    std::future<std::unique_ptr<Replay>> pendingReplay;
+    bool pendingReplayFast = false;
+
+    // what is on screen, so unchanged frames are neither drawn nor presented
+    State lastRenderedState = START_MENU;
+    bool wasStartButtonHovered = false;
+    bool wasDemoButtonHovered = false;
+    bool wasQuitButtonHovered = false;
+    bool forceRedraw = true;
 
+    void pollAssets();
     void handleInput();
     void update();
-    void render();
+    bool render(float alpha = 1.0f);
 
     void handleStartMenuInput(SDL_Event &e);
     void handleGameInput(SDL_Event &e);
@@ -48,7 +84,7 @@ private:
     void renderPausedMenu();
     void renderGameOverMenu();
 
-    void startNewGame();
+    void startNewGame(bool demo = false);
     void pauseGame();
     void resumeGame();
     void resetToMenu();
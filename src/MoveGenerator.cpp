@@ -0,0 +1,259 @@
+#include "MoveGenerator.hpp"
+
+namespace {
+    // every bit of open connected to a bit of seeds through open bits,
+    // in both directions (occluded fill, four doubling steps per side)
+    uint16_t fillRow(uint16_t seeds, uint16_t open) {
+        uint32_t m = seeds & open;
+        uint32_t g = open;
+        m |= g & (m << 1); g &= g << 1;
+        m |= g & (m << 2); g &= g << 2;
+        m |= g & (m << 4); g &= g << 4;
+        m |= g & (m << 8);
+        g = open;
+        m |= g & (m >> 1); g &= g >> 1;
+        m |= g & (m >> 2); g &= g >> 2;
+        m |= g & (m >> 4); g &= g >> 4;
+        m |= g & (m >> 8);
+        return static_cast<uint16_t>(m);
+    }
+
+    uint16_t shifted(uint16_t mask, int dx) {
+        return static_cast<uint16_t>(dx >= 0 ? mask << dx : mask >> -dx);
+    }
+}
+
+MoveGenerator::MoveGenerator() : orientationCount(0), startNode(0) {}
+
+void MoveGenerator::computeValid(const Board &board) {
+    // columns past the right wall count as filled
+    std::array<uint32_t, Board::HEIGHT> rows;
+    int stackTop = Board::HEIGHT;
+    for (int y = Board::HEIGHT - 1; y >= 0; --y) {
+        rows[y] = board.getRow(y) | ~static_cast<uint32_t>(Board::FULL_ROW);
+        if (board.getRow(y))
+            stackTop = y;
+    }
+
+    for (int r = 0; r < orientationCount; ++r) {
+        const Piece::Footprint &fp = orientations[r].getFootprint();
+        std::array<int, 4> dx, dy;
+        for (int i = 0; i < 4; ++i) {
+            dx[i] = fp.cells[i].x - fp.minX;
+            dy[i] = fp.cells[i].y - fp.minY;
+        }
+
+        // bit s of blocked: the box collides when its left column is at s.
+        // Shifted from box columns to the x of the shape origin.
+        valid[r].fill(0);
+        uint16_t *out = &valid[r][Y_OFFSET - fp.minY];
+        int shift = X_OFFSET - fp.minX;
+        // above the stack only the walls matter
+        int top = 0;
+        uint32_t wall = ~static_cast<uint32_t>(Board::FULL_ROW);
+        uint16_t open = static_cast<uint16_t>((~((wall >> dx[0]) | (wall >> dx[1]) | (wall >> dx[2]) | (wall >> dx[3])) & 0xFFFF) << shift);
+        for (; top + fp.height <= stackTop; ++top)
+            out[top] = open;
+        for (; top + fp.height <= Board::HEIGHT; ++top) {
+            uint32_t blocked = (rows[top + dy[0]] >> dx[0]) | (rows[top + dy[1]] >> dx[1]) |
+                               (rows[top + dy[2]] >> dx[2]) | (rows[top + dy[3]] >> dx[3]);
+            out[top] = static_cast<uint16_t>((~blocked & 0xFFFF) << shift);
+        }
+    }
+}
+
+bool MoveGenerator::rotateRow(int rotation, int y, uint16_t from) {
+    int next = (rotation + 1) % orientationCount;
+    const std::array<uint16_t, ROWS> &target = valid[next];
+    std::array<uint16_t, ROWS> &landed = reach[next];
+
+    // same rules as Simulation::step(ROTATE): in place first, then the
+    // first kick that fits, so each position lands in exactly one spot
+    uint16_t added = from & target[y] & ~landed[y];
+    landed[y] |= from & target[y];
+    uint16_t remaining = from & ~target[y];
+
+    for (const Simulation::Kick &kick : Simulation::WALL_KICKS) {
+        if (!remaining)
+            break;
+        int ky = y + kick.y;
+        if (ky < 0 || ky >= ROWS)
+            continue;
+        uint16_t fits = remaining & shifted(target[ky], -kick.x);
+        uint16_t moved = shifted(fits, kick.x);
+        added |= moved & ~landed[ky];
+        landed[ky] |= moved;
+        remaining &= ~fits;
+    }
+    return added != 0;
+}
+
+int MoveGenerator::rotationTarget(int rotation, int x, int y) const {
+    int next = (rotation + 1) % orientationCount;
+    const std::array<uint16_t, ROWS> &target = valid[next];
+
+    if ((target[y] >> x) & 1)
+        return encode(next, x, y);
+    for (const Simulation::Kick &kick : Simulation::WALL_KICKS) {
+        int kx = x + kick.x;
+        int ky = y + kick.y;
+        if (kx >= 0 && kx < COLUMNS && ky >= 0 && ky < ROWS && ((target[ky] >> kx) & 1))
+            return encode(next, kx, ky);
+    }
+    return -1;
+}
+
+int MoveGenerator::generate(const Board &board, const Piece &piece, int x, int y, Placement *out, int capacity) {
+    Piece::Tetromino type = piece.getTetromino();
+    Piece oriented(type);
+
+    orientationCount = Piece::distinctRotations(type);
+    for (int r = 0; r < orientationCount; ++r) {
+        orientations[r] = oriented;
+        oriented.rotate();
+    }
+    computeValid(board);
+
+    int rotation = piece.getRotation() % orientationCount;
+    int startX = x + X_OFFSET;
+    int startY = y + Y_OFFSET;
+    if (startX < 0 || startX >= COLUMNS || startY < 0 || startY >= ROWS || !((valid[rotation][startY] >> startX) & 1))
+        return 0;
+    startNode = encode(rotation, startX, startY);
+
+    for (std::array<uint16_t, ROWS> &rows : reach)
+        rows.fill(0);
+    reach[rotation][startY] = static_cast<uint16_t>(1u << startX);
+
+    // top to bottom, orientation after orientation: a row spreads sideways,
+    // falls into the row below and rotates into the next orientation, all
+    // handled later in the same pass. Only rotating from the last
+    // orientation back into the first needs another pass.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int r = 0; r < orientationCount; ++r) {
+            for (int ry = 0; ry < ROWS - 1; ++ry) {
+                if (!reach[r][ry])
+                    continue;
+                uint16_t row = reach[r][ry];
+                if (row != valid[r][ry]) {
+                    row = fillRow(row, valid[r][ry]);
+                    reach[r][ry] = row;
+                }
+                reach[r][ry + 1] |= row & valid[r][ry + 1];
+                if (orientationCount > 1 && rotateRow(r, ry, row) && r + 1 == orientationCount)
+                    changed = true;
+            }
+        }
+    }
+
+    // a reachable position is a placement when it cannot fall any further
+    int count = 0;
+    for (int r = 0; r < orientationCount; ++r) {
+        for (int ry = 0; ry < ROWS - 1; ++ry) {
+            for (uint16_t resting = reach[r][ry] & ~valid[r][ry + 1]; resting; resting &= resting - 1) {
+                if (count == capacity)
+                    return count;
+                int rx = __builtin_ctz(resting);
+                out[count++] = { orientations[r], static_cast<int8_t>(rx - X_OFFSET),
+                                 static_cast<int8_t>(ry - Y_OFFSET), encode(r, rx, ry) };
+            }
+        }
+    }
+    return count;
+}
+
+int MoveGenerator::getPath(const Placement &placement, Simulation::Action *out, int capacity) {
+    for (std::array<uint16_t, ROWS> &rows : visited)
+        rows.fill(0);
+
+    // breadth-first one soft drop at a time: every position reachable with
+    // k soft drops is found before any that needs k + 1
+    uint16_t target = placement.node;
+    int layerSize = 1;
+    bool found = false;
+    nextLayer[0] = startNode;
+    move[startNode] = START;
+
+    while (layerSize > 0 && !found) {
+        int head = 0;
+        int tail = 0;
+        for (int i = 0; i < layerSize; ++i) {
+            uint16_t node = nextLayer[i];
+            uint16_t bit = static_cast<uint16_t>(1u << (node % COLUMNS));
+            uint16_t &seen = visited[node / (ROWS * COLUMNS)][(node / COLUMNS) % ROWS];
+            if (seen & bit)
+                continue;
+            seen |= bit;
+            queue[tail++] = node;
+        }
+        layerSize = 0;
+
+        while (head < tail) {
+            uint16_t node = queue[head++];
+            if (node == target) {
+                found = true;
+                break;
+            }
+            int r = node / (ROWS * COLUMNS);
+            int ny = (node / COLUMNS) % ROWS;
+            int nx = node % COLUMNS;
+            const std::array<uint16_t, ROWS> &rows = valid[r];
+
+            auto visit = [&](int next, Move how) {
+                uint16_t bit = static_cast<uint16_t>(1u << (next % COLUMNS));
+                uint16_t &seen = visited[next / (ROWS * COLUMNS)][(next / COLUMNS) % ROWS];
+                if (seen & bit)
+                    return;
+                seen |= bit;
+                parent[next] = node;
+                move[next] = how;
+                queue[tail++] = static_cast<uint16_t>(next);
+            };
+            if (nx > 0 && ((rows[ny] >> (nx - 1)) & 1))
+                visit(node - 1, LEFT);
+            if ((rows[ny] >> (nx + 1)) & 1)
+                visit(node + 1, RIGHT);
+            if (orientationCount > 1) {
+                int rotated = rotationTarget(r, nx, ny);
+                if (rotated >= 0)
+                    visit(rotated, ROTATE);
+            }
+            // falling costs a soft drop, it waits for the next layer
+            if ((rows[ny + 1] >> nx) & 1) {
+                uint16_t below = static_cast<uint16_t>(node + COLUMNS);
+                if (!((visited[r][ny + 1] >> nx) & 1)) {
+                    parent[below] = node;
+                    move[below] = DOWN;
+                    nextLayer[layerSize++] = below;
+                }
+            }
+        }
+    }
+    if (!found)
+        return -1;
+
+    // walk back to the start (queue is free again), newest move first
+    int length = 0;
+    for (uint16_t node = target; move[node] != START; node = parent[node])
+        queue[length++] = node;
+    // the soft drops that end the path become a single hard drop
+    int end = 0;
+    while (end < length && move[queue[end]] == DOWN)
+        end++;
+    if (length - end + 1 > capacity)
+        return -1;
+
+    int count = 0;
+    for (int i = length - 1; i >= end; --i) {
+        switch (move[queue[i]]) {
+            case LEFT: out[count++] = Simulation::MOVE_LEFT; break;
+            case RIGHT: out[count++] = Simulation::MOVE_RIGHT; break;
+            case ROTATE: out[count++] = Simulation::ROTATE; break;
+            default: out[count++] = Simulation::SOFT_DROP; break;
+        }
+    }
+    out[count++] = Simulation::HARD_DROP;
+    return count;
+}
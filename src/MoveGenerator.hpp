@@ -0,0 +1,81 @@
+#ifndef _MOVE_GENERATOR_
+    #define _MOVE_GENERATOR_
+#include "Board.hpp"
+#include "Piece.hpp"
+#include "Simulation.hpp"
+#include <array>
+#include <cstdint>
+
+// Enumerates every resting position a piece can reach from where it stands
+// using the game's own inputs: sideways moves, soft drops (so tucks under
+// overhangs) and rotations with the Simulation wall kicks (so spins), over
+// (x, y, rotation) with the rotations that look the same merged.
+//
+// generate() floods reachable positions one board row at a time as 16-bit
+// masks, which is fast enough to call for every node of a search. The input
+// path to a placement is only needed for the move actually played, so
+// getPath() runs a breadth-first search for it on demand. Keep one
+// generator per thread; it holds the search state between the two calls.
+class MoveGenerator {
+    public:
+        // a buffer this large is never truncated
+        static constexpr int MAX_PLACEMENTS = 4 * Board::WIDTH * Board::HEIGHT;
+
+        struct Placement {
+            Piece piece;    // orientation it locks in (rotation reduced to distinct ones)
+            int8_t x;
+            int8_t y;
+            uint16_t node;  // search state, for getPath
+        };
+
+        MoveGenerator();
+
+        // writes up to capacity placements reachable by piece from (x, y) to
+        // out and returns how many were written, 0 if the piece does not fit
+        int generate(const Board &board, const Piece &piece, int x, int y, Placement *out, int capacity);
+        // inputs leading from the generate() start to placement, with as few
+        // soft drops as possible and ending with HARD_DROP; returns their
+        // count, or -1 if capacity is too small. Uses the board of the last
+        // generate().
+        int getPath(const Placement &placement, Simulation::Action *out, int capacity);
+
+    private:
+        // x and y are stored with an offset, a piece can sit at x or y < 0
+        // when its shape does not start in the first column or row
+        static constexpr int X_OFFSET = 4;
+        static constexpr int Y_OFFSET = 4;
+        static constexpr int COLUMNS = 16;
+        static constexpr int ROWS = 32;
+        static constexpr int NODE_COUNT = 4 * ROWS * COLUMNS;
+
+        enum Move : uint8_t { START, LEFT, RIGHT, ROTATE, DOWN };
+
+        using Rows = std::array<std::array<uint16_t, ROWS>, 4>;
+
+        // bit X_OFFSET + x of valid[r][Y_OFFSET + y] is set when the piece
+        // fits at (x, y) in rotation r, same layout for reach and visited
+        Rows valid;
+        Rows reach;
+        Rows visited;
+        std::array<Piece, 4> orientations;
+        int orientationCount;
+        uint16_t startNode;
+
+        // getPath search state, indexed by node
+        std::array<uint16_t, NODE_COUNT> parent;
+        std::array<uint8_t, NODE_COUNT> move;
+        std::array<uint16_t, NODE_COUNT> queue;
+        std::array<uint16_t, NODE_COUNT> nextLayer;
+
+        static uint16_t encode(int rotation, int x, int y) {
+            return static_cast<uint16_t>((rotation * ROWS + y) * COLUMNS + x);
+        }
+
+        void computeValid(const Board &board);
+        // rotates the reachable row y into the next orientation, true when
+        // that reached anything new
+        bool rotateRow(int rotation, int y, uint16_t from);
+        int rotationTarget(int rotation, int x, int y) const;
+};
+
+#endif /* _MOVE_GENERATOR_ */
@@ -0,0 +1,229 @@
+#include "MusicStream.hpp"
+#include "SoundMixer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const uint16_t WAVE_PCM = 1;
+    const uint16_t WAVE_FLOAT = 3;
+    // samples the audio callback moves out of the ring at a time
+    const size_t MIX_CHUNK = 1024;
+
+    bool readTag(SDL_RWops *file, char (&tag)[4]) {
+        return SDL_RWread(file, tag, 1, sizeof(tag)) == sizeof(tag);
+    }
+
+    bool sourceFormat(uint16_t tag, uint16_t bits, SDL_AudioFormat &format) {
+        if (tag == WAVE_PCM && bits == 8)
+            format = AUDIO_U8;
+        else if (tag == WAVE_PCM && bits == 16)
+            format = AUDIO_S16LSB;
+        else if (tag == WAVE_PCM && bits == 32)
+            format = AUDIO_S32LSB;
+        else if (tag == WAVE_FLOAT && bits == 32)
+            format = AUDIO_F32LSB;
+        else
+            return false;
+        return true;
+    }
+}
+
+MusicStream::MusicStream() : frequency(0), stopping(false), playing(false), primed(false), currentLevel(0),
+             volume(128), underruns(0), missingFrames(0), decodedFrames(0), tracksStarted(0) {}
+
+MusicStream::~MusicStream() {
+    close();
+}
+
+bool MusicStream::open(const std::string &playlistPath, int deviceFrequency) {
+    close();
+    std::ifstream list(playlistPath);
+    if (!list)
+        return false;
+
+    std::string directory = playlistPath.substr(0, playlistPath.find_last_of('/') + 1);
+    std::string line;
+    playlist.clear();
+    while (std::getline(list, line)) {
+        std::istringstream fields(line);
+        Track track;
+        std::string file;
+        if (line.empty() || line[0] == '#' || !(fields >> track.level >> file))
+            continue;
+        track.path = directory + file;
+        playlist.push_back(track);
+    }
+    std::sort(playlist.begin(), playlist.end(), [](const Track &a, const Track &b) { return a.level < b.level; });
+
+    frequency = deviceFrequency;
+    for (const Track &track : playlist) {
+        Source source;
+        if (!openSource(track.path, source)) {
+            playlist.clear();
+            return false;
+        }
+        closeSource(source);
+    }
+    if (playlist.empty()) {
+        std::cerr << "Empty music playlist " << playlistPath << std::endl;
+        return false;
+    }
+    decoder = std::thread(&MusicStream::decodeLoop, this);
+    return true;
+}
+
+void MusicStream::close() {
+    if (!decoder.joinable())
+        return;
+    stopping = true;
+    decoder.join();
+    stopping = false;
+}
+
+MusicStream::Stats MusicStream::getStats() const {
+    Stats stats;
+    stats.underruns = underruns.load(std::memory_order_relaxed);
+    stats.missingFrames = missingFrames.load(std::memory_order_relaxed);
+    stats.decodedFrames = decodedFrames.load(std::memory_order_relaxed);
+    stats.tracksStarted = tracksStarted.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const MusicStream::Track &MusicStream::pickTrack(int level) const {
+    const Track *picked = &playlist.front();
+    for (const Track &track : playlist) {
+        if (track.level <= level)
+            picked = &track;
+    }
+    return *picked;
+}
+
+bool MusicStream::openSource(const std::string &path, Source &source) const {
+    source = Source();
+    source.file = SDL_RWFromFile(path.c_str(), "rb");
+    if (!source.file) {
+        std::cerr << "Failed to open music " << path << "! SDL Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    // RIFF header, then chunks until "data"; "fmt " has to come first
+    char tag[4];
+    bool valid = readTag(source.file, tag) && std::memcmp(tag, "RIFF", 4) == 0;
+    SDL_ReadLE32(source.file);
+    valid = valid && readTag(source.file, tag) && std::memcmp(tag, "WAVE", 4) == 0;
+    uint16_t formatTag = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    while (valid && readTag(source.file, tag)) {
+        uint32_t size = SDL_ReadLE32(source.file);
+        if (std::memcmp(tag, "fmt ", 4) == 0 && size >= 16) {
+            formatTag = SDL_ReadLE16(source.file);
+            channels = SDL_ReadLE16(source.file);
+            rate = SDL_ReadLE32(source.file);
+            SDL_ReadLE32(source.file);              // byte rate
+            source.frameBytes = SDL_ReadLE16(source.file);
+            bits = SDL_ReadLE16(source.file);
+            SDL_RWseek(source.file, (size - 16) + (size & 1), RW_SEEK_CUR);
+        } else if (std::memcmp(tag, "data", 4) == 0) {
+            source.remaining = size;
+            break;
+        } else {
+            SDL_RWseek(source.file, size + (size & 1), RW_SEEK_CUR);
+        }
+    }
+
+    SDL_AudioFormat format;
+    if (!valid || source.remaining == 0 || channels == 0 || source.frameBytes == 0 ||
+        !sourceFormat(formatTag, bits, format)) {
+        std::cerr << "Cannot stream music " << path << ": not a PCM or float WAV file" << std::endl;
+        closeSource(source);
+        return false;
+    }
+    source.converter = SDL_NewAudioStream(format, static_cast<Uint8>(channels), static_cast<int>(rate),
+                                          AUDIO_S16SYS, 2, frequency);
+    if (!source.converter) {
+        std::cerr << "Cannot convert music " << path << "! SDL Error: " << SDL_GetError() << std::endl;
+        closeSource(source);
+        return false;
+    }
+    return true;
+}
+
+void MusicStream::closeSource(Source &source) const {
+    if (source.converter)
+        SDL_FreeAudioStream(source.converter);
+    if (source.file)
+        SDL_RWclose(source.file);
+    source = Source();
+}
+
+void MusicStream::decodeLoop() {
+    Source source = Source();
+    std::vector<Uint8> input(MUSIC_READ_BYTES);
+    // converted samples not in the ring yet, from index pending on
+    std::vector<int16_t> output;
+    size_t pending = 0;
+
+    while (!stopping) {
+        if (pending < output.size()) {
+            pending += ring.push(output.data() + pending, output.size() - pending);
+            primed = true;
+            if (pending < output.size())
+                std::this_thread::sleep_for(std::chrono::milliseconds(MUSIC_POLL_MS));
+            continue;
+        }
+
+        // a track ended (or none started yet): the next one is decoded
+        // right away, its first samples follow the last ones in the ring
+        if (!source.file) {
+            if (!openSource(pickTrack(currentLevel.load(std::memory_order_relaxed)).path, source))
+                break;
+            tracksStarted++;
+        }
+
+        uint32_t want = std::min<uint32_t>(source.remaining, MUSIC_READ_BYTES / source.frameBytes * source.frameBytes);
+        size_t got = SDL_RWread(source.file, input.data(), 1, want);
+        source.remaining -= static_cast<uint32_t>(got);
+        if (got > 0)
+            SDL_AudioStreamPut(source.converter, input.data(), static_cast<int>(got));
+        bool ended = got == 0 || source.remaining == 0;
+        if (ended)
+            SDL_AudioStreamFlush(source.converter);
+
+        int available = SDL_AudioStreamAvailable(source.converter);
+        output.resize(static_cast<size_t>(available) / sizeof(int16_t));
+        pending = 0;
+        if (available > 0)
+            SDL_AudioStreamGet(source.converter, output.data(), available);
+        decodedFrames += output.size() / 2;
+        if (ended)
+            closeSource(source);
+    }
+    closeSource(source);
+}
+
+void MusicStream::mix(int16_t *out, size_t frames) {
+    // nothing decoded yet is a start, not an underrun
+    if (!playing.load(std::memory_order_relaxed) || !primed.load(std::memory_order_acquire))
+        return;
+
+    int gain = volume.load(std::memory_order_relaxed);
+    int16_t chunk[MIX_CHUNK];
+    size_t samples = frames * 2;
+    size_t done = 0;
+    while (done < samples) {
+        size_t wanted = std::min(MIX_CHUNK, samples - done);
+        size_t got = ring.pop(chunk, wanted);
+        SoundMixer::mixSamples(out + done, chunk, got, gain);
+        done += got;
+        if (got < wanted)
+            break;
+    }
+    if (done < samples) {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        missingFrames.fetch_add((samples - done) / 2, std::memory_order_relaxed);
+    }
+}
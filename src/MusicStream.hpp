@@ -0,0 +1,95 @@
+#ifndef _MUSIC_STREAM_
+    #define _MUSIC_STREAM_
+#include <SDL2/SDL.h>
+#include "SpscQueue.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+// decoded music waiting to be played, in 16-bit samples (128 KB): about
+// 0.75 s of 44.1 kHz stereo, whatever the length of the tracks
+#define MUSIC_RING_SAMPLES (1 << 16)
+// bytes read from a track file at a time
+#define MUSIC_READ_BYTES 16384
+// how long the decoder sleeps when the ring is full enough
+#define MUSIC_POLL_MS 20
+
+// Streams WAV tracks from disk into a fixed ring buffer on a background
+// thread, converted to 16-bit stereo at the device rate, and mixes them
+// from the audio callback. Memory stays the same for any track length.
+//
+// The playlist is a text file, one "<level> <file>" per line (files next
+// to it): the track playing is the one with the highest level not above
+// the current game level. A track loops until the level picks another
+// one, the switch happens at the end of the track with no gap.
+class MusicStream {
+    public:
+        struct Stats {
+            uint64_t underruns;         // callbacks that got less music than asked
+            uint64_t missingFrames;     // frames played as silence because of them
+            uint64_t decodedFrames;
+            uint32_t tracksStarted;
+        };
+
+        MusicStream();
+        ~MusicStream();
+
+        MusicStream(const MusicStream &) = delete;
+        MusicStream &operator=(const MusicStream &) = delete;
+
+        // reads the playlist and starts decoding; false when there is no
+        // playlist, or (with a message on std::cerr) when one of its tracks
+        // is not a WAV file we can stream: the caller then falls back to
+        // SDL_mixer
+        bool open(const std::string &playlistPath, int frequency);
+        void close();
+        bool isOpen() const { return decoder.joinable(); }
+
+        // game thread
+        void setLevel(int level) { currentLevel.store(level, std::memory_order_relaxed); }
+        void setPlaying(bool playing) { this->playing.store(playing, std::memory_order_relaxed); }
+        bool isPlaying() const { return playing.load(std::memory_order_relaxed); }
+        // 0-128 like SDL_mixer
+        void setVolume(int volume) { this->volume.store(volume, std::memory_order_relaxed); }
+        Stats getStats() const;
+
+        // audio callback: adds frames of music to out (16-bit stereo)
+        void mix(int16_t *out, size_t frames);
+
+    private:
+        struct Track {
+            int level;
+            std::string path;
+        };
+        // a WAV file being read, the data chunk only
+        struct Source {
+            SDL_RWops *file;
+            SDL_AudioStream *converter;
+            uint32_t remaining;         // data bytes left
+            uint32_t frameBytes;
+        };
+
+        std::vector<Track> playlist;
+        int frequency;
+        SpscQueue<int16_t, MUSIC_RING_SAMPLES> ring;
+        std::thread decoder;
+        std::atomic<bool> stopping;
+        std::atomic<bool> playing;
+        // set once the ring got its first samples
+        std::atomic<bool> primed;
+        std::atomic<int> currentLevel;
+        std::atomic<int> volume;
+
+        std::atomic<uint64_t> underruns;
+        std::atomic<uint64_t> missingFrames;
+        std::atomic<uint64_t> decodedFrames;
+        std::atomic<uint32_t> tracksStarted;
+
+        const Track &pickTrack(int level) const;
+        bool openSource(const std::string &path, Source &source) const;
+        void closeSource(Source &source) const;
+        void decodeLoop();
+};
+
+#endif /* _MUSIC_STREAM_ */
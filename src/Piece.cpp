@@ -1,180 +1,250 @@
 #include "Piece.hpp"
 
-Piece::Piece(Tetromino type) : currentRotation(0), tetrominoType(type) {
+namespace {
     // definir tout les tetrominos
-    switch (type) {
-        case I:
-            // I tetromino (line)
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 1, 1},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0}
-            }};
-            rotations[2] = rotations[0];
-            rotations[3] = rotations[1];
-            break;
-        case O:
-            // O tetromino (square)
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = rotations[0];
-            rotations[2] = rotations[0];
-            rotations[3] = rotations[0];
-            break;
-        case T:
-            // T tetromino
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 1, 1, 1, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[2] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 1, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[3] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 1, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            break;
-        case S:
-            // S tetromino
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 1, 1, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 0, 1, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[2] = rotations[0];
-            rotations[3] = rotations[1];
-            break;
-        case Z:
-            // Z tetromino
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 1, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[2] = rotations[0];
-            rotations[3] = rotations[1];
-            break;
-        case J:
-            // J tetromino
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 1, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 1, 0, 0, 0},
-                {0, 1, 1, 1, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[2] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[3] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 1, 0},
-                {0, 0, 0, 1, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            break;
-        case L:
-            // L tetromino
-            rotations[0] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 1, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[1] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 1, 0},
-                {0, 1, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[2] = {{
-                {0, 0, 0, 0, 0},
-                {0, 1, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 1, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            rotations[3] = {{
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 1, 0},
-                {0, 1, 1, 1, 0},
-                {0, 0, 0, 0, 0},
-                {0, 0, 0, 0, 0}
-            }};
-            break;
+
+    // I tetromino (line)
+    constexpr Piece::Shape I_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 1},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape I_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0}
+    }};
+
+    // O tetromino (square)
+    constexpr Piece::Shape O_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    // T tetromino
+    constexpr Piece::Shape T_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 1, 1, 1, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape T_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape T_2 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape T_3 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 1, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    // S tetromino
+    constexpr Piece::Shape S_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 1, 1, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape S_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 0, 1, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    // Z tetromino
+    constexpr Piece::Shape Z_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape Z_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 1, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    // J tetromino
+    constexpr Piece::Shape J_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 1, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape J_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 1, 0, 0, 0},
+        {0, 1, 1, 1, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape J_2 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape J_3 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 0},
+        {0, 0, 0, 1, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    // L tetromino
+    constexpr Piece::Shape L_0 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 1, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape L_1 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 0},
+        {0, 1, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape L_2 = {{
+        {0, 0, 0, 0, 0},
+        {0, 1, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+    constexpr Piece::Shape L_3 = {{
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 1, 0},
+        {0, 1, 1, 1, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}
+    }};
+
+    constexpr std::array<std::array<Piece::Shape, 4>, TETROMINO_COUNT> SHAPES = {{
+        {{ I_0, I_1, I_0, I_1 }},
+        {{ O_0, O_0, O_0, O_0 }},
+        {{ T_0, T_1, T_2, T_3 }},
+        {{ S_0, S_1, S_0, S_1 }},
+        {{ Z_0, Z_1, Z_0, Z_1 }},
+        {{ J_0, J_1, J_2, J_3 }},
+        {{ L_0, L_1, L_2, L_3 }}
+    }};
+
+    // shapes are indexed shape[x][y], like the board
+    constexpr Piece::Footprint makeFootprint(const Piece::Shape &shape) {
+        Piece::Footprint fp{};
+        int minX = 5, minY = 5, maxX = -1, maxY = -1;
+        int count = 0;
+
+        for (int x = 0; x < 5; ++x) {
+            for (int y = 0; y < 5; ++y) {
+                if (!shape[x][y])
+                    continue;
+                if (count < 4)
+                    fp.cells[count] = { static_cast<int8_t>(x), static_cast<int8_t>(y) };
+                count++;
+                minX = x < minX ? x : minX;
+                maxX = x > maxX ? x : maxX;
+                minY = y < minY ? y : minY;
+                maxY = y > maxY ? y : maxY;
+            }
+        }
+        fp.minX = static_cast<int8_t>(minX);
+        fp.minY = static_cast<int8_t>(minY);
+        fp.width = static_cast<int8_t>(maxX - minX + 1);
+        fp.height = static_cast<int8_t>(maxY - minY + 1);
+        for (const auto &cell : fp.cells) {
+            fp.rowMasks[cell.y - minY] |= static_cast<uint8_t>(1u << (cell.x - minX));
+        }
+        return fp;
     }
+
+    constexpr std::array<std::array<Piece::Footprint, 4>, TETROMINO_COUNT> makeFootprints() {
+        std::array<std::array<Piece::Footprint, 4>, TETROMINO_COUNT> table{};
+        for (int t = 0; t < TETROMINO_COUNT; ++t) {
+            for (int r = 0; r < 4; ++r) {
+                table[t][r] = makeFootprint(SHAPES[t][r]);
+            }
+        }
+        return table;
+    }
+
+    constexpr auto FOOTPRINTS = makeFootprints();
+
+    constexpr bool allTetrominoes() {
+        for (const auto &rotations : FOOTPRINTS) {
+            for (const auto &fp : rotations) {
+                int bits = 0;
+                for (uint8_t mask : fp.rowMasks) {
+                    for (; mask; mask &= mask - 1)
+                        bits++;
+                }
+                if (bits != 4 || fp.width > 4 || fp.height > 4)
+                    return false;
+            }
+        }
+        return true;
+    }
+    static_assert(allTetrominoes(), "every rotation must cover exactly four cells");
+
+    constexpr bool rotationsRepeat() {
+        for (int t = 0; t < TETROMINO_COUNT; ++t) {
+            int period = Piece::distinctRotations(static_cast<Piece::Tetromino>(t));
+            for (int r = 0; r < 4; ++r) {
+                for (int x = 0; x < 5; ++x) {
+                    for (int y = 0; y < 5; ++y) {
+                        if (SHAPES[t][r][x][y] != SHAPES[t][r % period][x][y])
+                            return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+    static_assert(rotationsRepeat(), "distinctRotations must match the shape tables");
 }
 
+const std::array<std::array<Piece::Shape, 4>, TETROMINO_COUNT> Piece::shapes = SHAPES;
+const std::array<std::array<Piece::Footprint, 4>, TETROMINO_COUNT> Piece::footprints = FOOTPRINTS;
+
+Piece::Piece(Tetromino type) : tetrominoType(static_cast<uint8_t>(type)), currentRotation(0) {}
+
 void Piece::rotate() {
     currentRotation = (currentRotation + 1) % 4;
 }
 
 const Piece::Shape &Piece::getShape() const {
-    return rotations[currentRotation];
+    return shapes[tetrominoType][currentRotation];
 }
 
 char Piece::getType() const {
@@ -1,6 +1,7 @@
 #ifndef _PIECE_
     #define _PIECE_
 #include <array>
+#include <cstdint>
 #define TETROMINO_COUNT 7
 
 class Piece {
@@ -8,16 +9,43 @@ class Piece {
         enum Tetromino { I, O, T, S, Z, J, L };
         using Shape = std::array<std::array<int, 5>, 5>;
 
+        struct Cell {
+            int8_t x;
+            int8_t y;
+        };
+
+        // Precomputed layout of one rotation: the tight bounding box inside
+        // the 5x5 shape, one bitmask per box row (bit i = column minX + i)
+        // and the four occupied cells relative to the shape origin.
+        struct Footprint {
+            std::array<uint8_t, 4> rowMasks;
+            int8_t minX, minY;
+            int8_t width, height;
+            std::array<Cell, 4> cells;
+        };
+
         Piece() : Piece(I) {}
         Piece(Tetromino type);
         void rotate();
         const Shape &getShape() const;
+        const Footprint &getFootprint() const { return footprints[tetrominoType][currentRotation]; }
         char getType() const;
-    
+        Tetromino getTetromino() const { return static_cast<Tetromino>(tetrominoType); }
+        int getRotation() const { return currentRotation; }
+
+        // number of different orientations: rotation r looks exactly like
+        // rotation r % distinctRotations (O has one, I, S and Z have two)
+        static constexpr int distinctRotations(Tetromino type) {
+            return type == O ? 1 : (type == I || type == S || type == Z) ? 2 : 4;
+        }
+
     private:
-        std::array<Shape, 4> rotations;
-        int currentRotation;
-        Tetromino tetrominoType;
+        // shared by every Piece, built at compile time in Piece.cpp
+        static const std::array<std::array<Shape, 4>, TETROMINO_COUNT> shapes;
+        static const std::array<std::array<Footprint, 4>, TETROMINO_COUNT> footprints;
+
+        uint8_t tetrominoType;
+        uint8_t currentRotation;
 };
 
 #endif /* _PIECE_ */
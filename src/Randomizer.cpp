@@ -0,0 +1,102 @@
+#include "Randomizer.hpp"
+
+namespace {
+    inline uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    // splitmix64, recommended to expand a single seed into xoshiro state
+    inline uint64_t splitMix(uint64_t &x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
+
+Randomizer::Randomizer(uint64_t seedValue, Mode mode) : seed(seedValue) {
+    uint64_t x = seedValue;
+    for (auto &word : state.rng) {
+        word = splitMix(x);
+    }
+    for (int i = 0; i < TETROMINO_COUNT; ++i) {
+        state.bag[i] = static_cast<uint8_t>(i);
+    }
+    state.bagPosition = TETROMINO_COUNT;
+    state.mode = static_cast<uint8_t>(mode);
+}
+
+uint64_t Randomizer::nextRaw() {
+    std::array<uint64_t, 4> &s = state.rng;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// unbiased value in [0, bound) (Lemire's multiply and reject)
+uint32_t Randomizer::nextBelow(uint32_t bound) {
+    uint64_t product = (nextRaw() >> 32) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            product = (nextRaw() >> 32) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+void Randomizer::refillBag() {
+    // Fisher-Yates over the previous bag, any permutation works as a start
+    for (int i = TETROMINO_COUNT - 1; i > 0; --i) {
+        uint32_t j = nextBelow(static_cast<uint32_t>(i + 1));
+        uint8_t tmp = state.bag[i];
+        state.bag[i] = state.bag[j];
+        state.bag[j] = tmp;
+    }
+    state.bagPosition = 0;
+}
+
+Piece::Tetromino Randomizer::next() {
+    if (getMode() == PURE_RANDOM)
+        return static_cast<Piece::Tetromino>(nextBelow(TETROMINO_COUNT));
+
+    if (state.bagPosition >= TETROMINO_COUNT)
+        refillBag();
+    return static_cast<Piece::Tetromino>(state.bag[state.bagPosition++]);
+}
+
+void Randomizer::discard(uint64_t count) {
+    while (count-- > 0) {
+        next();
+    }
+}
+
+void Randomizer::jump() {
+    static const uint64_t JUMP[] = {
+        0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+        0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+    };
+    std::array<uint64_t, 4> jumped = { 0, 0, 0, 0 };
+
+    for (uint64_t word : JUMP) {
+        for (int b = 0; b < 64; ++b) {
+            if (word & (1ull << b)) {
+                for (int i = 0; i < 4; ++i) {
+                    jumped[i] ^= state.rng[i];
+                }
+            }
+            nextRaw();
+        }
+    }
+    state.rng = jumped;
+}
@@ -0,0 +1,47 @@
+#ifndef _RANDOMIZER_
+    #define _RANDOMIZER_
+#include "Piece.hpp"
+#include <array>
+#include <cstdint>
+
+// Per-game piece generator on top of xoshiro256**. Given the same seed and
+// mode it always produces the same sequence, and its whole state fits in a
+// small POD that can be saved and restored.
+class Randomizer {
+    public:
+        enum Mode {
+            BAG_7,          // every run of 7 pieces is a shuffle of all tetrominoes
+            PURE_RANDOM     // each piece drawn independently
+        };
+
+        struct State {
+            std::array<uint64_t, 4> rng;
+            std::array<uint8_t, TETROMINO_COUNT> bag;
+            uint8_t bagPosition;
+            uint8_t mode;
+        };
+
+        explicit Randomizer(uint64_t seed, Mode mode = PURE_RANDOM);
+
+        Piece::Tetromino next();
+        // skips the next count pieces
+        void discard(uint64_t count);
+        // advances the generator by 2^128 draws, giving a non-overlapping stream
+        void jump();
+
+        State snapshot() const { return state; }
+        void restore(const State &saved) { state = saved; }
+
+        uint64_t getSeed() const { return seed; }
+        Mode getMode() const { return static_cast<Mode>(state.mode); }
+
+    private:
+        uint64_t seed;
+        State state;
+
+        uint64_t nextRaw();
+        uint32_t nextBelow(uint32_t bound);
+        void refillBag();
+};
+
+#endif /* _RANDOMIZER_ */
@@ -1,135 +1,97 @@
 #include "Renderer.hpp"
 #include <string>
 
-Renderer::Renderer(SDL_Renderer *r) : renderer(r) {
+Renderer::Renderer(SDL_Renderer *r, const char *fontPath) : renderer(r), glyphs(nullptr), cells(new CellBatch(r)), layers() {
+    layersSupported = SDL_RenderTargetSupported(renderer);
     if (TTF_Init() == -1) {
         printf("SDL_ttf could not initialize! SDL_ttf Error: %s\n", TTF_GetError());
     }
-    
-    font = TTF_OpenFont(FONT_PATH, 20);
-    if (!font) {
-        printf("Failed to load font! SDL_ttf Error: %s\n", TTF_GetError());
-        printf("Tried multiple font paths but all failed.\n");
-    }
+    glyphs = new GlyphAtlas(renderer, fontPath);
 }
 
 Renderer::~Renderer() {
-    if (font) {
-        TTF_CloseFont(font);
-        font = NULL;
-    }
+    invalidateLayers();
+    delete cells;
+    delete glyphs;
+    glyphs = NULL;
     TTF_Quit();
 }
 
-void Renderer::setPieceColor(char pieceType, bool isGhost) {
-    if (isGhost) {
-        SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
+void Renderer::setFontData(std::vector<uint8_t> data) {
+    glyphs->setFontData(std::move(data));
+    invalidateLayers();
+}
+
+void Renderer::invalidateLayers() {
+    for (auto &layer : layers) {
+        if (layer.texture)
+            SDL_DestroyTexture(layer.texture);
+        layer = Layer();
+    }
+    if (scene.texture)
+        SDL_DestroyTexture(scene.texture);
+    scene = Scene();
+}
+
+// Static content is painted once into a render-target texture and then
+// composited with a single copy. A layer is repainted when it is missing or
+// its size changed (window resize); invalidateLayers() forces a repaint.
+template <typename Paint>
+void Renderer::drawCachedLayer(LayerId id, const SDL_Rect &area, Paint paint) {
+    Layer &layer = layers[id];
+
+    if (layersSupported && (layer.width != area.w || layer.height != area.h)) {
+        if (layer.texture)
+            SDL_DestroyTexture(layer.texture);
+        layer.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, area.w, area.h);
+        layer.width = area.w;
+        layer.height = area.h;
+        layer.painted = false;
+        if (layer.texture)
+            SDL_SetTextureBlendMode(layer.texture, SDL_BLENDMODE_NONE);
+    }
+    if (!layer.texture) {
+        paint(area);
         return;
     }
-    
-    switch (pieceType) {
-        case 'I': SDL_SetRenderDrawColor(renderer, 0, 255, 255, 255);   break;  // cyan
-        case 'O': SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);   break;  // jaune
-        case 'T': SDL_SetRenderDrawColor(renderer, 128, 0, 128, 255);   break;  // violet
-        case 'S': SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);     break;  // vert
-        case 'Z': SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);     break;  // rouge
-        case 'J': SDL_SetRenderDrawColor(renderer, 0, 0, 255, 255);     break;  // bleu
-        case 'L': SDL_SetRenderDrawColor(renderer, 255, 165, 0, 255);   break;  // orange
-        default:  SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);     break;  // rouge par défaut
+
+    if (!layer.painted) {
+        SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+        SDL_SetRenderTarget(renderer, layer.texture);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        SDL_RenderClear(renderer);
+        paint(SDL_Rect{ 0, 0, area.w, area.h });
+        SDL_SetRenderTarget(renderer, previousTarget);
+        layer.painted = true;
     }
+    SDL_RenderCopy(renderer, layer.texture, NULL, &area);
 }
 
 void Renderer::drawPiece(const Piece &piece, int offsetX, int offsetY, int size, bool isGhost) {
-    const auto &shape = piece.getShape();
-    
-    setPieceColor(piece.getType(), isGhost);
-    for (int x = 0; x < 5; ++x) {
-        for (int y = 0; y < 5; ++y) {
-            if (shape[x][y]) {
-                SDL_Rect rect = { offsetX + x * size, offsetY + y * size, size, size };
-                if (isGhost) {
-                    SDL_RenderDrawRect(renderer, &rect);
-                } else {
-                    // save la couleur de base
-                    Uint8 r, g, b, a;
-                    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
-                    SDL_RenderFillRect(renderer, &rect);
-
-                    SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
-                    SDL_RenderDrawRect(renderer, &rect);
-                    
-                    // restore la couleur pour le next block
-                    SDL_SetRenderDrawColor(renderer, r, g, b, a);
-                }
-            }
+    CellBatch::Colour colour = CellBatch::colourOf(piece.getType(), isGhost);
+
+    for (const Piece::Cell &cell : piece.getFootprint().cells) {
+        SDL_Rect rect = { offsetX + cell.x * size, offsetY + cell.y * size, size, size };
+        if (isGhost) {
+            cells->addOutline(colour, rect);
+        } else {
+            cells->addBlock(colour, rect);
         }
     }
 }
 
 void Renderer::renderText(const char* text, SDL_Rect destRect, SDL_Color color, int fontSize) {
-    if (fontSize == 0) {
-        if (!font)
-            return;
-            
-        SDL_Surface* textSurface = TTF_RenderText_Solid(font, text, color);
-        if (!textSurface) {
-            printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-            return;
-        }
-        
-        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-        if (!textTexture) {
-            printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
-            SDL_FreeSurface(textSurface);
-            return;
-        }
-        if (destRect.w == 0 || destRect.h == 0) {
-            destRect.w = textSurface->w;
-            destRect.h = textSurface->h;
-        }
-        SDL_RenderCopy(renderer, textTexture, NULL, &destRect);
-        
-        SDL_FreeSurface(textSurface);
-        SDL_DestroyTexture(textTexture);
-    } else {
-        TTF_Font* tempFont = TTF_OpenFont(FONT_PATH, fontSize);
-        if (!tempFont) {
-            printf("Failed to load font with size %d! SDL_ttf Error: %s\n", fontSize, TTF_GetError());
-            return;
-        }
-        
-        SDL_Surface* textSurface = TTF_RenderText_Solid(tempFont, text, color);
-        if (!textSurface) {
-            printf("Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError());
-            TTF_CloseFont(tempFont);
-            return;
-        }
-        
-        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-        if (!textTexture) {
-            printf("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
-            SDL_FreeSurface(textSurface);
-            TTF_CloseFont(tempFont);
-            return;
-        }
-        if (destRect.w == 0 || destRect.h == 0) {
-            destRect.w = textSurface->w;
-            destRect.h = textSurface->h;
-        }
-        SDL_RenderCopy(renderer, textTexture, NULL, &destRect);
-        
-        SDL_FreeSurface(textSurface);
-        SDL_DestroyTexture(textTexture);
-        TTF_CloseFont(tempFont);
-    }
+    glyphs->draw(text, fontSize == 0 ? DEFAULT_FONT_SIZE : fontSize, destRect, color);
+}
+
+bool Renderer::measureText(const char* text, int fontSize, int &width, int &height) {
+    return glyphs->measure(text, fontSize == 0 ? DEFAULT_FONT_SIZE : fontSize, width, height);
 }
 
 void Renderer::renderTextCentered(char const *text, int x, int y, SDL_Color color, int fontSize) {
-    TTF_Font *textFont = (fontSize == 0) ? font : TTF_OpenFont(FONT_PATH, fontSize);
-    if (!textFont)
-        return;
     int textWidth, textHeight;
-    TTF_SizeText(textFont, text, &textWidth, &textHeight);
+    if (!measureText(text, fontSize, textWidth, textHeight))
+        return;
 
     SDL_Rect destRect = {
         x - textWidth / 2,
@@ -137,96 +99,86 @@ void Renderer::renderTextCentered(char const *text, int x, int y, SDL_Color colo
         0,
         0
     };
-    if (fontSize == 0) {
-        renderText(text, destRect, color);
-    } else {
-        renderText(text, destRect, color, fontSize);
-        TTF_CloseFont(textFont);
-    }
+    renderText(text, destRect, color, fontSize);
 }
 
 void Renderer::drawBoardGrid(const Board &board, int offsetX, int offsetY) {
-    const auto &grid = board.getGrid();
-    for (int x = 0; x < Board::WIDTH; ++x) {
-        for (int y = 0; y < Board::HEIGHT; ++y) {
-            if (grid[x][y] != 0) {
-                if (y >= 0 && y < Board::HEIGHT) {
-                    setPieceColor(grid[x][y]);
-                    SDL_Rect rect = { offsetX + x * blockSize, offsetY + y * blockSize, blockSize, blockSize };
-                    SDL_RenderFillRect(renderer, &rect);
-                    SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
-                    SDL_RenderDrawRect(renderer, &rect);
-                }
-            } else {
-                // Fill empty cell with black
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_Rect area = { offsetX, offsetY, Board::WIDTH * blockSize, Board::HEIGHT * blockSize };
+    drawCachedLayer(LAYER_BOARD_GRID, area, [this](const SDL_Rect &grid) {
+        paintEmptyGrid(grid.x, grid.y);
+    });
+
+    for (int y = 0; y < Board::HEIGHT; ++y) {
+        if (board.getRow(y) == 0)
+            continue;
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            char cell = board.getCell(x, y);
+            if (cell != 0) {
                 SDL_Rect rect = { offsetX + x * blockSize, offsetY + y * blockSize, blockSize, blockSize };
-                SDL_RenderFillRect(renderer, &rect);
-                // Draw dark grey outline
-                SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
-                SDL_RenderDrawRect(renderer, &rect);
+                cells->addBlock(CellBatch::colourOf(cell), rect);
             }
         }
     }
 }
 
+void Renderer::paintEmptyGrid(int offsetX, int offsetY) {
+    for (int x = 0; x < Board::WIDTH; ++x) {
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            // Fill empty cell with black
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            SDL_Rect rect = { offsetX + x * blockSize, offsetY + y * blockSize, blockSize, blockSize };
+            SDL_RenderFillRect(renderer, &rect);
+            // Draw dark grey outline
+            SDL_SetRenderDrawColor(renderer, 40, 40, 40, 255);
+            SDL_RenderDrawRect(renderer, &rect);
+        }
+    }
+}
+
 void Renderer::drawGhostPiece(const Board &board, const Piece &piece, int posX, int posY, int offsetX, int offsetY) {
     int dropY = board.findDropPosition(piece, posX, posY);
     if (dropY > posY) {
-        const auto &shape = piece.getShape();        
-        Uint8 r, g, b, a;
-        SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
-        setPieceColor(piece.getType(), false);
-        
-        for (int x = 0; x < 5; ++x) {
-            for (int y = 0; y < 5; ++y) {
-                if (shape[x][y]) {
-                    int boardX = posX + x;
-                    int boardY = dropY + y;
-                    if (boardX >= 0 && boardX < Board::WIDTH && boardY >= 0 && boardY < Board::HEIGHT) {
-                        SDL_Rect rect = { offsetX + boardX * blockSize, offsetY + boardY * blockSize, blockSize, blockSize };
-                        SDL_RenderDrawRect(renderer, &rect);
-                        SDL_Rect innerRect = { 
-                            offsetX + boardX * blockSize + 1, 
-                            offsetY + boardY * blockSize + 1, 
-                            blockSize - 2, 
-                            blockSize - 2 
-                        };
-                        SDL_RenderDrawRect(renderer, &innerRect);
-                    }
-                }
+        CellBatch::Colour colour = CellBatch::colourOf(piece.getType());
+
+        for (const Piece::Cell &cell : piece.getFootprint().cells) {
+            int boardX = posX + cell.x;
+            int boardY = dropY + cell.y;
+            if (boardX >= 0 && boardX < Board::WIDTH && boardY >= 0 && boardY < Board::HEIGHT) {
+                SDL_Rect rect = { offsetX + boardX * blockSize, offsetY + boardY * blockSize, blockSize, blockSize };
+                cells->addOutline(colour, rect);
+                SDL_Rect innerRect = { 
+                    offsetX + boardX * blockSize + 1, 
+                    offsetY + boardY * blockSize + 1, 
+                    blockSize - 2, 
+                    blockSize - 2 
+                };
+                cells->addOutline(colour, innerRect);
             }
         }
-        
-        SDL_SetRenderDrawColor(renderer, r, g, b, a);
     }
 }
 
-void Renderer::drawNextPiecesPanel(const std::vector<Piece> &nextPieces, int panelX, int panelY, int nextPieceSize) {
+void Renderer::drawNextPiecesPanel(const Simulation::Queue &nextPieces, int panelX, int panelY, int nextPieceSize) {
     SDL_Rect nextPanel;
     nextPanel.x = panelX;
     nextPanel.y = panelY - 50;
     nextPanel.w = 5 * nextPieceSize + 20;
     nextPanel.h = 4 * (5 * nextPieceSize + 20) + 30;
-    
-    // le meme gradient que le score panel
-    for (int y = 0; y < nextPanel.h; y++) {
-        int r = 40 + (y * 20 / nextPanel.h);
-        int g = 0;
-        int b = 80 + (y * 40 / nextPanel.h);
-        
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-        SDL_RenderDrawLine(renderer, 
-                          nextPanel.x, nextPanel.y + y, 
-                          nextPanel.x + nextPanel.w, nextPanel.y + y);
+
+    drawCachedLayer(LAYER_NEXT_PANEL, nextPanel, [&](const SDL_Rect &panel) {
+        paintNextPiecesFrame(panel, nextPieceSize);
+    });
+
+    for (size_t i = 0; i < nextPieces.size() && i < 4; ++i) {
+        int pieceY = nextPanel.y + 50 + i * (5 * nextPieceSize + 10);
+        drawPiece(nextPieces[i], nextPanel.x + 10, pieceY, nextPieceSize);
     }
-    
-    SDL_SetRenderDrawColor(renderer, 180, 180, 200, 255);
-    SDL_RenderDrawRect(renderer, &nextPanel);
-    
-    SDL_Rect innerBorder = {nextPanel.x + 3, nextPanel.y + 3, nextPanel.w - 6, nextPanel.h - 6};
-    SDL_SetRenderDrawColor(renderer, 100, 100, 140, 255);
-    SDL_RenderDrawRect(renderer, &innerBorder);
+}
+
+void Renderer::paintNextPiecesFrame(const SDL_Rect &nextPanel, int nextPieceSize) {
+    // le meme gradient que le score panel
+    paintPanelGradient(nextPanel);
+    paintPanelBorders(nextPanel);
     
     SDL_Rect textRect = { nextPanel.x + 10, nextPanel.y + 10, 0, 0 };
     SDL_Color goldColor = { 255, 255, 0, 255 };
@@ -237,7 +189,7 @@ void Renderer::drawNextPiecesPanel(const std::vector<Piece> &nextPieces, int pan
                       nextPanel.x + 10, nextPanel.y + 40, 
                       nextPanel.x + nextPanel.w - 10, nextPanel.y + 40);
     
-    for (size_t i = 0; i < nextPieces.size() && i < 4; ++i) {
+    for (int i = 0; i < 4; ++i) {
         int pieceY = nextPanel.y + 50 + i * (5 * nextPieceSize + 10);
         
         SDL_Rect pieceBackground = { 
@@ -252,44 +204,53 @@ void Renderer::drawNextPiecesPanel(const std::vector<Piece> &nextPieces, int pan
         
         SDL_SetRenderDrawColor(renderer, 100, 100, 140, 255);
         SDL_RenderDrawRect(renderer, &pieceBackground);
-        
-        drawPiece(nextPieces[i], nextPanel.x + 10, pieceY, nextPieceSize);
     }
 }
 
-void Renderer::drawHeldPiecePanel(const Piece* heldPiece, int panelX, int panelY, int heldPieceSize) {
-    SDL_Rect holdPanel;
-    holdPanel.x = panelX - 15;
-    holdPanel.y = panelY + 200;
-    holdPanel.w = 5 * heldPieceSize + 20;
-    holdPanel.h = 5 * heldPieceSize + 80;
-    
-    for (int y = 0; y < holdPanel.h; y++) {
-        int r = 40 + (y * 20 / holdPanel.h);
+void Renderer::paintPanelGradient(const SDL_Rect &panel) {
+    for (int y = 0; y < panel.h; y++) {
+        int r = 40 + (y * 20 / panel.h);
         int g = 0;
-        int b = 80 + (y * 40 / holdPanel.h);
+        int b = 80 + (y * 40 / panel.h);
         
         SDL_SetRenderDrawColor(renderer, r, g, b, 255);
         SDL_RenderDrawLine(renderer, 
-                          holdPanel.x, holdPanel.y + y, 
-                          holdPanel.x + holdPanel.w, holdPanel.y + y);
+                          panel.x, panel.y + y, 
+                          panel.x + panel.w, panel.y + y);
     }
-    
+}
+
+void Renderer::paintPanelBorders(const SDL_Rect &panel) {
+    // Outer border
     SDL_SetRenderDrawColor(renderer, 180, 180, 200, 255);
-    SDL_RenderDrawRect(renderer, &holdPanel);
+    SDL_RenderDrawRect(renderer, &panel);
     
-    SDL_Rect innerBorder = {holdPanel.x + 3, holdPanel.y + 3, holdPanel.w - 6, holdPanel.h - 6};
+    // Inner border
+    SDL_Rect innerBorder = {panel.x + 3, panel.y + 3, panel.w - 6, panel.h - 6};
     SDL_SetRenderDrawColor(renderer, 100, 100, 140, 255);
     SDL_RenderDrawRect(renderer, &innerBorder);
+}
+
+void Renderer::drawHeldPiecePanel(const Piece* heldPiece, int panelX, int panelY, int heldPieceSize) {
+    SDL_Rect holdPanel;
+    holdPanel.x = panelX - 15;
+    holdPanel.y = panelY + 200;
+    holdPanel.w = 5 * heldPieceSize + 20;
+    holdPanel.h = 5 * heldPieceSize + 80;
     
-    SDL_Rect textRect = { holdPanel.x + 10, holdPanel.y + 10, 0, 0 };
-    SDL_Color goldColor = { 255, 255, 0, 255 };
-    renderText("HOLD", textRect, goldColor);
-    
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 100);
-    SDL_RenderDrawLine(renderer, 
-                      holdPanel.x + 10, holdPanel.y + 40, 
-                      holdPanel.x + holdPanel.w - 10, holdPanel.y + 40);
+    drawCachedLayer(LAYER_HOLD_PANEL, holdPanel, [this](const SDL_Rect &panel) {
+        paintPanelGradient(panel);
+        paintPanelBorders(panel);
+
+        SDL_Rect textRect = { panel.x + 10, panel.y + 10, 0, 0 };
+        SDL_Color goldColor = { 255, 255, 0, 255 };
+        renderText("HOLD", textRect, goldColor);
+
+        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 100);
+        SDL_RenderDrawLine(renderer, 
+                          panel.x + 10, panel.y + 40, 
+                          panel.x + panel.w - 10, panel.y + 40);
+    });
     
     if (heldPiece != nullptr) {
         int pieceY = holdPanel.y + 50;
@@ -315,9 +276,7 @@ void Renderer::drawHeldPiecePanel(const Piece* heldPiece, int panelX, int panelY
     }
 }
 
-void Renderer::drawScorePanel(int score, int level) {
-    float pulseIntensity = calculateScorePulseIntensity(score);
-    
+void Renderer::drawScorePanel(int score, int level, float pulseIntensity) {
     SDL_Rect scorePanel = calculateScorePanelPosition();
     
     drawScorePanelBackground(scorePanel, pulseIntensity);
@@ -363,42 +322,25 @@ SDL_Rect Renderer::calculateScorePanelPosition() {
 }
 
 void Renderer::drawScorePanelBackground(const SDL_Rect& scorePanel, float pulseIntensity) {
-    for (int y = 0; y < scorePanel.h; y++) {
-        int r = 40 + (y * 20 / scorePanel.h);
-        int g = 0;
-        int b = 80 + (y * 40 / scorePanel.h);
-        
-        if (pulseIntensity > 0) {
-            r = r + static_cast<int>(pulseIntensity * 50);
-            g = g + static_cast<int>(pulseIntensity * 20);
-            b = b + static_cast<int>(pulseIntensity * 70);
-            r = std::min(255, r);
-            g = std::min(255, g);
-            b = std::min(255, b);
-        }
-        
-        SDL_SetRenderDrawColor(renderer, r, g, b, 255);
-        SDL_RenderDrawLine(renderer, 
-                          scorePanel.x, scorePanel.y + y, 
-                          scorePanel.x + scorePanel.w, scorePanel.y + y);
+    drawCachedLayer(LAYER_SCORE_PANEL, scorePanel, [this](const SDL_Rect &panel) {
+        paintPanelGradient(panel);
+    });
+
+    if (pulseIntensity > 0) {
+        // brighten the cached gradient, additive blending saturates at 255 like before
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_ADD);
+        SDL_SetRenderDrawColor(renderer,
+                               static_cast<Uint8>(pulseIntensity * 50),
+                               static_cast<Uint8>(pulseIntensity * 20),
+                               static_cast<Uint8>(pulseIntensity * 70),
+                               255);
+        SDL_RenderFillRect(renderer, &scorePanel);
+        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
     }
 }
 
 void Renderer::drawScorePanelBorders(const SDL_Rect& scorePanel) {
-    // Outer border
-    SDL_SetRenderDrawColor(renderer, 180, 180, 200, 255);
-    SDL_RenderDrawRect(renderer, &scorePanel);
-    
-    // Inner border
-    SDL_Rect innerBorder = {
-        scorePanel.x + 3, 
-        scorePanel.y + 3, 
-        scorePanel.w - 6, 
-        scorePanel.h - 6
-    };
-    
-    SDL_SetRenderDrawColor(renderer, 100, 100, 140, 255);
-    SDL_RenderDrawRect(renderer, &innerBorder);
+    paintPanelBorders(scorePanel);
 }
 
 void Renderer::drawScoreSection(const SDL_Rect& scorePanel, int score, float pulseIntensity) {
@@ -472,7 +414,16 @@ void Renderer::drawLevelIndicatorDots(const SDL_Rect& scorePanel, int level) {
         SDL_RenderDrawRect(renderer, &dot);
     }
 }
+
 void Renderer::drawGradientBackground(int windowWidth, int windowHeight, bool isPurpleTheme) {
+    SDL_Rect area = { 0, 0, windowWidth, windowHeight };
+    LayerId layer = isPurpleTheme ? LAYER_GAME_BACKGROUND : LAYER_MENU_BACKGROUND;
+    drawCachedLayer(layer, area, [=](const SDL_Rect &) {
+        paintGradientBackground(windowWidth, windowHeight, isPurpleTheme);
+    });
+}
+
+void Renderer::paintGradientBackground(int windowWidth, int windowHeight, bool isPurpleTheme) {
     for (int y = 0; y < windowHeight; y++) {
         float ratio = static_cast<float>(y) / windowHeight;
         int r, g, b;
@@ -494,8 +445,10 @@ void Renderer::drawGradientBackground(int windowWidth, int windowHeight, bool is
 void Renderer::drawMainMenu(int windowWidth,
                             int windowHeight,
                             const SDL_Rect &startButtonRect,
+                            const SDL_Rect &demoButtonRect,
                             const SDL_Rect &quitButtonRect,
                             bool isStartButtonHovered,
+                            bool isDemoButtonHovered,
                             bool isQuitButtonHovered
 ) {
     drawGradientBackground(windowWidth, windowHeight, false);
@@ -504,22 +457,32 @@ void Renderer::drawMainMenu(int windowWidth,
 
     SDL_SetRenderDrawColor(renderer, 100, 100, 140, 255);
     SDL_RenderDrawRect(renderer, &startButtonRect);
+    SDL_RenderDrawRect(renderer, &demoButtonRect);
     SDL_RenderDrawRect(renderer, &quitButtonRect);
 
     SDL_Color startColor = isStartButtonHovered ?
         SDL_Color{255, 255, 0, 255} :
         SDL_Color{255, 255, 255, 255};
 
+    SDL_Color demoColor = isDemoButtonHovered ?
+        SDL_Color{255, 255, 0, 255} :
+        SDL_Color{255, 255, 255, 255};
+
     SDL_Color quitColor = isQuitButtonHovered ?
         SDL_Color{255, 255, 0, 255} :
         SDL_Color{255, 255, 255, 255};
 
-    renderTextCentered("Start Game", windowWidth / 2, windowHeight / 2 - 50, startColor, 40);
-    renderTextCentered("Quit", windowWidth / 2, windowHeight / 2 + 50, quitColor, 40);
+    renderTextCentered("Start Game", windowWidth / 2, windowHeight / 2 - 80, startColor, 40);
+    renderTextCentered("Demo", windowWidth / 2, windowHeight / 2, demoColor, 40);
+    renderTextCentered("Quit", windowWidth / 2, windowHeight / 2 + 80, quitColor, 40);
     if (isStartButtonHovered) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
         SDL_RenderDrawRect(renderer, &startButtonRect);
     }
+    if (isDemoButtonHovered) {
+        SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
+        SDL_RenderDrawRect(renderer, &demoButtonRect);
+    }
     if (isQuitButtonHovered) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
         SDL_RenderDrawRect(renderer, &quitButtonRect);
@@ -575,38 +538,107 @@ void Renderer::drawGameOverMenu(int windowWidth, int windowHeight) {
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 }
 
-void Renderer::drawBoard(const Board &board,
-                         const Piece &piece,
-                         int posX, int posY,
-                         const std::vector<Piece> &nextPieces,
-                         const Piece* heldPiece
-) {
+bool Renderer::drawBoard(const Simulation &simulation, float fallOffset, bool force) {
     int windowWidth, windowHeight;
     SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
-    drawGradientBackground(windowWidth, windowHeight, true);
 
+    const Board &board = simulation.getBoard();
     int boardWidthPixels = Board::WIDTH * blockSize;
     int boardHeightPixels = Board::HEIGHT * blockSize;
 
     int offsetX = (windowWidth - boardWidthPixels) / 2;
     int offsetY = (windowHeight - boardHeightPixels) / 2 - blockSize;
+    // fallOffset is in rows (-1..0), used to interpolate gravity between ticks
+    int pieceOffsetY = offsetY + static_cast<int>((simulation.getPieceY() + fallOffset) * blockSize);
+    float pulseIntensity = calculateScorePulseIntensity(board.getScore());
+
+    SceneState state;
+    state.width = windowWidth;
+    state.height = windowHeight;
+    state.cells = board.getCellsVersion();
+    state.piece = simulation.getPieceVersion();
+    state.pieceOffsetY = pieceOffsetY;
+    state.queue = simulation.getQueueVersion();
+    state.hold = simulation.getHoldVersion();
+    state.score = board.getScoreVersion();
+    state.scorePulsing = pulseIntensity > 0;
+
+    // the scene persists in a texture so unchanged regions are kept as is
+    if (!ensureScene(windowWidth, windowHeight)) {
+        force = true;
+    } else if (scene.painted && !force && state == scene.state && !state.scorePulsing) {
+        return false;
+    }
+    bool redrawAll = force || !scene.painted || state.width != scene.state.width || state.height != scene.state.height;
+
+    SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+    if (scene.texture)
+        SDL_SetRenderTarget(renderer, scene.texture);
+
+    if (redrawAll)
+        drawGradientBackground(windowWidth, windowHeight, true);
+
+    if (redrawAll || state.cells != scene.state.cells || state.piece != scene.state.piece ||
+        state.pieceOffsetY != scene.state.pieceOffsetY) {
+        // one extra row on top for a piece sliding in from above the board
+        SDL_Rect boardRegion = { offsetX, offsetY - blockSize, boardWidthPixels, boardHeightPixels + blockSize };
+        if (!redrawAll)
+            copyLayerRegion(LAYER_GAME_BACKGROUND, boardRegion);
+        drawBoardGrid(board, offsetX, offsetY);
+        drawGhostPiece(board, simulation.getCurrentPiece(), simulation.getPieceX(), simulation.getPieceY(), offsetX, offsetY);
+        drawPiece(simulation.getCurrentPiece(), offsetX + simulation.getPieceX() * blockSize, pieceOffsetY, blockSize);
+    }
 
-    drawBoardGrid(board, offsetX, offsetY);
-    drawGhostPiece(board, piece, posX, posY, offsetX, offsetY);
-    drawPiece(piece, offsetX + posX * blockSize, offsetY + posY * blockSize, blockSize);
-
-    int nextPiecesPanelX = offsetX + boardWidthPixels + 50;
-    int nextPiecesPanelY = offsetY + 100;
     int nextPieceSize = blockSize - 10;
-    drawNextPiecesPanel(nextPieces, nextPiecesPanelX, nextPiecesPanelY, nextPieceSize);
+    if (redrawAll || state.queue != scene.state.queue) {
+        int nextPiecesPanelX = offsetX + boardWidthPixels + 50;
+        int nextPiecesPanelY = offsetY + 100;
+        drawNextPiecesPanel(simulation.getNextPieces(), nextPiecesPanelX, nextPiecesPanelY, nextPieceSize);
+    }
 
-    int heldPiecePanelX = offsetX - 200;
-    int heldPiecePanelY = offsetY + 100;
-    int heldPieceSize = blockSize - 10;
-    drawHeldPiecePanel(heldPiece, heldPiecePanelX, heldPiecePanelY, heldPieceSize);
+    if (redrawAll || state.hold != scene.state.hold) {
+        int heldPiecePanelX = offsetX - 200;
+        int heldPiecePanelY = offsetY + 100;
+        drawHeldPiecePanel(simulation.getHeldPiece(), heldPiecePanelX, heldPiecePanelY, nextPieceSize);
+    }
+
+    // keep redrawing while the pulse fades, and once more when it ends
+    if (redrawAll || state.score != scene.state.score || state.scorePulsing || scene.state.scorePulsing) {
+        drawScorePanel(board.getScore(), board.getLevel(), pulseIntensity);
+    }
+
+    // every cell queued above goes out in a handful of batched calls
+    cells->flush();
 
-    // draw a score panel
-    drawScorePanel(board.getScore(), board.getLevel());
+    if (scene.texture) {
+        SDL_SetRenderTarget(renderer, previousTarget);
+        SDL_RenderCopy(renderer, scene.texture, NULL, NULL);
+    }
+    scene.state = state;
+    scene.painted = scene.texture != nullptr;
+    return true;
+}
+
+bool Renderer::ensureScene(int width, int height) {
+    if (!layersSupported)
+        return false;
+    if (scene.texture && scene.width == width && scene.height == height)
+        return true;
+
+    if (scene.texture)
+        SDL_DestroyTexture(scene.texture);
+    scene.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+    scene.width = width;
+    scene.height = height;
+    scene.painted = false;
+    if (!scene.texture)
+        return false;
+    SDL_SetTextureBlendMode(scene.texture, SDL_BLENDMODE_NONE);
+    return true;
+}
 
-    SDL_RenderPresent(renderer);
+void Renderer::copyLayerRegion(LayerId id, const SDL_Rect &region) {
+    const Layer &layer = layers[id];
+    if (layer.texture && layer.painted)
+        SDL_RenderCopy(renderer, layer.texture, &region, &region);
 }
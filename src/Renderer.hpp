@@ -3,40 +3,106 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <array>
 #include <vector>
 #include <string>
 
 #include "Board.hpp"
 #include "Piece.hpp"
+#include "Simulation.hpp"
+#include "GlyphAtlas.hpp"
+#include "CellBatch.hpp"
 
 #define FONT_PATH "./assets/fonts/OpenSans-Bold.ttf"
+#define DEFAULT_FONT_SIZE 20
 
 class Renderer {
     public:
-        Renderer(SDL_Renderer *r);
+        // a null fontPath draws no text until setFontData()
+        Renderer(SDL_Renderer *r, const char *fontPath = FONT_PATH);
         ~Renderer();
-        void drawBoard(const Board &board, const Piece &piece, int x, int y, const std::vector<Piece> &nextPieces, const Piece* heldPiece = nullptr);
+        // redraws only the regions whose version changed since the last call;
+        // returns false (and draws nothing) when the scene is unchanged
+        bool drawBoard(const Simulation &simulation, float fallOffset = 0.0f, bool force = false);
         void renderText(const char* text, SDL_Rect destRect, SDL_Color color = {255, 255, 255, 255}, int fontSize = 0);
         void renderTextCentered(const char* text, int x, int y, SDL_Color color, int fontSize = 0);
+        bool measureText(const char* text, int fontSize, int &width, int &height);
         void drawMainMenu(int windowWidth, int windowHeight,
-            const SDL_Rect &startButtonRect, const SDL_Rect &quitButtonRect,
-            bool isStartButtonHovered, bool isQuitButtonHovered);
+            const SDL_Rect &startButtonRect, const SDL_Rect &demoButtonRect, const SDL_Rect &quitButtonRect,
+            bool isStartButtonHovered, bool isDemoButtonHovered, bool isQuitButtonHovered);
         void drawPauseMenu(int windowWidth, int windowHeight);
         void drawGameOverMenu(int windowWidth, int windowHeight);
         void drawGradientBackground(int windowWidth, int windowHeight, bool isPurpleTheme = true);
+        // drops every cached layer, e.g. after SDL_RENDER_TARGETS_RESET or a theme change
+        void invalidateLayers();
+        // font file read by AssetManager; layers painted without text are redrawn
+        void setFontData(std::vector<uint8_t> data);
     
     private:
+        enum LayerId {
+            LAYER_MENU_BACKGROUND,
+            LAYER_GAME_BACKGROUND,
+            LAYER_BOARD_GRID,
+            LAYER_NEXT_PANEL,
+            LAYER_HOLD_PANEL,
+            LAYER_SCORE_PANEL,
+            LAYER_COUNT
+        };
+
+        struct Layer {
+            SDL_Texture *texture = nullptr;
+            int width = 0;
+            int height = 0;
+            bool painted = false;
+        };
+
+        // what the game scene texture currently shows
+        struct SceneState {
+            int width = 0, height = 0;
+            uint32_t cells = 0, piece = 0, queue = 0, hold = 0, score = 0;
+            int pieceOffsetY = 0;
+            bool scorePulsing = false;
+
+            bool operator==(const SceneState &other) const {
+                return width == other.width && height == other.height && cells == other.cells &&
+                       piece == other.piece && queue == other.queue && hold == other.hold &&
+                       score == other.score && pieceOffsetY == other.pieceOffsetY &&
+                       scorePulsing == other.scorePulsing;
+            }
+        };
+
+        struct Scene {
+            SDL_Texture *texture = nullptr;
+            int width = 0;
+            int height = 0;
+            bool painted = false;
+            SceneState state;
+        };
+
         SDL_Renderer *renderer;
-        TTF_Font *font;
+        GlyphAtlas *glyphs;
+        CellBatch *cells;
+        std::array<Layer, LAYER_COUNT> layers;
+        bool layersSupported;
+        Scene scene;
         const int blockSize = 45;
 
+        template <typename Paint>
+        void drawCachedLayer(LayerId id, const SDL_Rect &area, Paint paint);
+        bool ensureScene(int width, int height);
+        void copyLayerRegion(LayerId id, const SDL_Rect &region);
+        void paintGradientBackground(int windowWidth, int windowHeight, bool isPurpleTheme);
+        void paintEmptyGrid(int offsetX, int offsetY);
+        void paintNextPiecesFrame(const SDL_Rect &nextPanel, int nextPieceSize);
+        void paintPanelGradient(const SDL_Rect &panel);
+        void paintPanelBorders(const SDL_Rect &panel);
+
         void drawPiece(const Piece &piece, int offsetX, int offsetY, int size, bool isGhost = false);
-        void setPieceColor(char pieceType, bool isGhost = false);
         void drawBoardGrid(const Board &board, int offsetX, int offsetY);
         void drawGhostPiece(const Board &board, const Piece &piece, int posX, int posY, int offsetX = 0, int offsetY = 0);
-        void drawNextPiecesPanel(const std::vector<Piece> &nextPieces, int panelX, int panelY, int nextPieceSize);
+        void drawNextPiecesPanel(const Simulation::Queue &nextPieces, int panelX, int panelY, int nextPieceSize);
         void drawHeldPiecePanel(const Piece* heldPiece, int panelX, int panelY, int heldPieceSize);
-        void drawScorePanel(int score, int level);
+        void drawScorePanel(int score, int level, float pulseIntensity);
 
         // Score panel helper methods
         float calculateScorePulseIntensity(int score);
@@ -0,0 +1,188 @@
+#include "Replay.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    const char MAGIC[4] = { 'T', 'R', 'P', '1' };
+    const int ACTION_BITS = 3;
+    static_assert(Simulation::HOLD < (1 << ACTION_BITS), "actions no longer fit in a replay input");
+
+    // LEB128: 7 bits per byte, high bit set when more bytes follow
+    void writeVarint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool readVarint(const std::vector<uint8_t> &in, size_t &pos, uint64_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+            uint8_t byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+}
+
+bool Replay::load(const std::string &path, Replay &replay) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open replay " << path << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t pos = sizeof(MAGIC);
+    uint64_t seed;
+    if (data.size() < sizeof(MAGIC) || !std::equal(MAGIC, MAGIC + sizeof(MAGIC), data.begin()) ||
+        !readVarint(data, pos, seed) || pos >= data.size() || data[pos] > Randomizer::PURE_RANDOM) {
+        std::cerr << "Not a replay file: " << path << std::endl;
+        return false;
+    }
+    replay.seed = seed;
+    replay.mode = static_cast<Randomizer::Mode>(data[pos++]);
+    replay.inputs.clear();
+    replay.complete = false;
+
+    // a truncated last input is dropped, everything before it still plays
+    uint64_t tick = 0;
+    uint64_t code;
+    while (readVarint(data, pos, code)) {
+        tick += code >> ACTION_BITS;
+        Simulation::Action action = static_cast<Simulation::Action>(code & ((1 << ACTION_BITS) - 1));
+        if (action == Simulation::NONE) {
+            replay.complete = true;
+            break;
+        }
+        if (action > Simulation::HOLD) {
+            std::cerr << "Corrupted replay " << path << ", stopping at tick " << tick << std::endl;
+            break;
+        }
+        replay.inputs.push_back({ tick, action });
+    }
+    replay.endTick = replay.complete ? tick : replay.inputs.empty() ? 0 : replay.inputs.back().tick;
+    return true;
+}
+
+std::future<std::unique_ptr<Replay>> Replay::loadAsync(const std::string &path) {
+    return std::async(std::launch::async, [path]() {
+        std::unique_ptr<Replay> replay(new Replay());
+        if (!load(path, *replay))
+            replay.reset();
+        return replay;
+    });
+}
+
+ReplayRecorder::ReplayRecorder(const std::string &path, uint64_t seed, Randomizer::Mode mode)
+    : file(path, std::ios::binary | std::ios::trunc), open(false), finished(false), lastTick(0), stopping(false) {
+    if (!file) {
+        std::cerr << "Failed to create replay " << path << std::endl;
+        finished = true;
+        return;
+    }
+    open = true;
+    pending.assign(MAGIC, MAGIC + sizeof(MAGIC));
+    writeVarint(pending, seed);
+    pending.push_back(static_cast<uint8_t>(mode));
+    writer = std::thread(&ReplayRecorder::writerLoop, this);
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    finish(lastTick);
+}
+
+void ReplayRecorder::append(uint64_t tick, Simulation::Action action) {
+    // inputs only go forward in time
+    uint64_t delta = tick > lastTick ? tick - lastTick : 0;
+    lastTick += delta;
+    std::lock_guard<std::mutex> lock(mutex);
+    writeVarint(pending, (delta << ACTION_BITS) | action);
+}
+
+void ReplayRecorder::record(uint64_t tick, Simulation::Action action) {
+    if (finished || action == Simulation::NONE)
+        return;
+    append(tick, action);
+    wakeUp.notify_one();
+}
+
+void ReplayRecorder::finish(uint64_t tick) {
+    if (finished)
+        return;
+    finished = true;
+    append(tick, Simulation::NONE);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    writer.join();
+}
+
+void ReplayRecorder::writerLoop() {
+    std::vector<uint8_t> chunk;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait(lock, [this] { return stopping || !pending.empty(); });
+        bool last = stopping;
+        chunk.swap(pending);
+        lock.unlock();
+
+        if (!chunk.empty()) {
+            file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            file.flush();
+            if (!file)
+                std::cerr << "Failed to write replay data" << std::endl;
+            chunk.clear();
+        }
+        lock.lock();
+        if (last && pending.empty())
+            return;
+    }
+}
+
+ReplayPlayer::ReplayPlayer(std::unique_ptr<Replay> replay) : replay(std::move(replay)), next(0) {}
+
+Simulation ReplayPlayer::createSimulation() const {
+    return Simulation(replay->seed, replay->mode);
+}
+
+int ReplayPlayer::advance(Simulation &simulation) {
+    // taken before the inputs of this tick, like a seek resumes from
+    timeline.capture(simulation);
+
+    int events = Simulation::EVENT_NONE;
+    uint64_t tick = simulation.getTickCount();
+    while (next < replay->inputs.size() && replay->inputs[next].tick <= tick)
+        events |= simulation.step(replay->inputs[next++].action);
+    if (!isFinished(simulation))
+        events |= simulation.tick();
+    return events;
+}
+
+bool ReplayPlayer::isFinished(const Simulation &simulation) const {
+    return simulation.isGameOver() ||
+           (simulation.getTickCount() >= replay->endTick && next >= replay->inputs.size());
+}
+
+void ReplayPlayer::seek(Simulation &simulation, uint64_t tick) {
+    uint64_t now = simulation.getTickCount();
+    const Simulation::Snapshot *saved = timeline.find(tick);
+    if (!saved)
+        saved = timeline.getOldest();
+
+    if (saved && !(tick >= now && saved->tickCount <= now)) {
+        simulation.restore(*saved);
+        // everything before the snapshot tick is in it, the rest is to play
+        next = std::lower_bound(replay->inputs.begin(), replay->inputs.end(), saved->tickCount,
+                                [](const Replay::Input &input, uint64_t t) { return input.tick < t; }) -
+               replay->inputs.begin();
+    }
+    while (simulation.getTickCount() < tick && !isFinished(simulation))
+        advance(simulation);
+}
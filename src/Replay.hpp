@@ -0,0 +1,107 @@
+#ifndef _REPLAY_
+    #define _REPLAY_
+#include "Simulation.hpp"
+#include "Timeline.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A game is its seed, its randomizer and the inputs with the tick they were
+// played on: Simulation is deterministic, so replaying the inputs on the
+// same ticks gives back the same game.
+//
+// File layout: "TRP1", varint seed, one byte of randomizer mode, then one
+// varint per input, (ticks since the previous input << 3) | action. An
+// input with action NONE ends the game (its ticks lead to the last tick).
+// A human plays a few inputs per second, most fit in one or two bytes.
+struct Replay {
+    struct Input {
+        uint64_t tick;
+        Simulation::Action action;
+    };
+
+    uint64_t seed = 0;
+    Randomizer::Mode mode = Randomizer::PURE_RANDOM;
+    std::vector<Input> inputs;
+    uint64_t endTick = 0;
+    // false when the file stops before the end marker (game still running
+    // or crashed), endTick is then the tick of the last input
+    bool complete = false;
+
+    // false (and a message on std::cerr) when the file cannot be read or
+    // is not a replay
+    static bool load(const std::string &path, Replay &replay);
+    // load() on its own thread; the result is nullptr on failure
+    static std::future<std::unique_ptr<Replay>> loadAsync(const std::string &path);
+};
+
+// Encodes inputs as they are played and writes them from a background
+// thread, so the game thread never waits for the disk. Each record() is
+// on disk shortly after, a crash only loses the last few inputs.
+class ReplayRecorder {
+    public:
+        ReplayRecorder(const std::string &path, uint64_t seed, Randomizer::Mode mode);
+        ~ReplayRecorder();
+
+        ReplayRecorder(const ReplayRecorder &) = delete;
+        ReplayRecorder &operator=(const ReplayRecorder &) = delete;
+
+        bool isOpen() const { return open; }
+        // action played after tick ticks (Simulation::getTickCount())
+        void record(uint64_t tick, Simulation::Action action);
+        // writes the end marker and waits for everything to be on disk;
+        // later calls do nothing
+        void finish(uint64_t tick);
+
+    private:
+        std::ofstream file;
+        bool open;
+        bool finished;
+        uint64_t lastTick;
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        // bytes waiting for the writer thread
+        std::vector<uint8_t> pending;
+        bool stopping;
+        std::thread writer;
+
+        void append(uint64_t tick, Simulation::Action action);
+        void writerLoop();
+};
+
+// Feeds a replay into a Simulation built from the same seed and mode, and
+// keeps a Timeline of it on the way so it can be scrubbed back and forth.
+class ReplayPlayer {
+    public:
+        explicit ReplayPlayer(std::unique_ptr<Replay> replay);
+
+        const Replay &getReplay() const { return *replay; }
+        // the simulation to play the replay on
+        Simulation createSimulation() const;
+
+        // the inputs due at the current tick, then one tick; returns the
+        // events of both like Simulation::step() and tick()
+        int advance(Simulation &simulation);
+        // game over, or the recording stopped there
+        bool isFinished(const Simulation &simulation) const;
+        // moves simulation to tick: restores the closest snapshot before it
+        // and plays the inputs from there (a forward seek past the last
+        // snapshot just keeps playing). Stops at the oldest snapshot kept
+        // and at the end of the replay.
+        void seek(Simulation &simulation, uint64_t tick);
+
+    private:
+        std::unique_ptr<Replay> replay;
+        // first input not played yet
+        size_t next;
+        Timeline timeline;
+};
+
+#endif /* _REPLAY_ */
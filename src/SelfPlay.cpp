@@ -0,0 +1,120 @@
+#include "SelfPlay.hpp"
+#include <chrono>
+#include <vector>
+
+namespace {
+    // splitmix64, used to spread consecutive seeds into unrelated streams
+    uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // per-worker totals, padded so workers never share a cache line
+    struct alignas(64) WorkerTotals {
+        long long score = 0;
+        long long lines = 0;
+        long long pieces = 0;
+        int bestScore = 0;
+    };
+}
+
+RandomPlacementPolicy::RandomPlacementPolicy(uint64_t seed)
+    : state(mix(seed)), plannedPiece(-1), targetX(0), rotationsLeft(0) {}
+
+uint32_t RandomPlacementPolicy::nextRandom() {
+    state = mix(state);
+    return static_cast<uint32_t>(state >> 32);
+}
+
+Simulation::Action RandomPlacementPolicy::chooseAction(const Simulation &simulation) {
+    if (plannedPiece != simulation.getPieceCount()) {
+        plannedPiece = simulation.getPieceCount();
+        rotationsLeft = nextRandom() % 4;
+        targetX = static_cast<int>(nextRandom() % Board::WIDTH) - 2;
+    }
+    if (rotationsLeft > 0) {
+        rotationsLeft--;
+        return Simulation::ROTATE;
+    }
+    // walls may stop us short of the target, drop as soon as we stop moving
+    int x = simulation.getPieceX();
+    const Board &board = simulation.getBoard();
+    const Piece &piece = simulation.getCurrentPiece();
+    int y = simulation.getPieceY();
+    if (x < targetX && board.isValidPosition(piece, x + 1, y))
+        return Simulation::MOVE_RIGHT;
+    if (x > targetX && board.isValidPosition(piece, x - 1, y))
+        return Simulation::MOVE_LEFT;
+    return Simulation::HARD_DROP;
+}
+
+SelfPlayRunner::SelfPlayRunner(int threads) : pool(threads), randomizerMode(Randomizer::PURE_RANDOM), archive(nullptr) {}
+
+uint64_t SelfPlayRunner::gameSeed(uint64_t batchSeed, int game) {
+    return mix(batchSeed ^ mix(static_cast<uint64_t>(game)));
+}
+
+GameResult SelfPlayRunner::playGame(uint64_t seed, Randomizer::Mode mode, MovePolicy &policy, int maxPieces,
+                                    SessionArchiveWriter *archive) {
+    Simulation simulation(seed, mode);
+    std::vector<uint16_t> placements;
+
+    while (!simulation.isGameOver() && (maxPieces <= 0 || simulation.getPieceCount() < maxPieces)) {
+        // a hard drop and the gravity right after can both lock a piece
+        int events = simulation.step(policy.chooseAction(simulation));
+        if (archive && (events & Simulation::EVENT_PLACE))
+            placements.push_back(SessionArchive::encode(simulation.getLastPlacement()));
+        events = simulation.tick();
+        if (archive && (events & Simulation::EVENT_PLACE))
+            placements.push_back(SessionArchive::encode(simulation.getLastPlacement()));
+    }
+    if (archive)
+        archive->append(simulation, placements);
+
+    GameResult result;
+    result.seed = seed;
+    result.score = simulation.getBoard().getScore();
+    result.level = simulation.getBoard().getLevel();
+    result.lines = simulation.getTotalLines();
+    result.pieces = simulation.getPieceCount();
+    result.ticks = simulation.getTickCount();
+    return result;
+}
+
+BatchStats SelfPlayRunner::run(int games, uint64_t seed, const PolicyFactory &makePolicy, int maxPieces,
+                               std::vector<GameResult> *results) {
+    std::vector<WorkerTotals> totals(pool.size());
+    if (results)
+        results->assign(games > 0 ? games : 0, GameResult());
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(games, [&](int game, int worker) {
+        uint64_t gameSeedValue = gameSeed(seed, game);
+        std::unique_ptr<MovePolicy> policy = makePolicy(gameSeedValue);
+        GameResult result = playGame(gameSeedValue, randomizerMode, *policy, maxPieces, archive);
+
+        WorkerTotals &mine = totals[worker];
+        mine.score += result.score;
+        mine.lines += result.lines;
+        mine.pieces += result.pieces;
+        if (result.score > mine.bestScore)
+            mine.bestScore = result.score;
+        if (results)
+            (*results)[game] = result;
+    });
+    auto end = std::chrono::steady_clock::now();
+
+    BatchStats stats = {};
+    stats.games = games;
+    for (const auto &worker : totals) {
+        stats.totalScore += worker.score;
+        stats.totalLines += worker.lines;
+        stats.totalPieces += worker.pieces;
+        if (worker.bestScore > stats.bestScore)
+            stats.bestScore = worker.bestScore;
+    }
+    stats.seconds = std::chrono::duration<double>(end - start).count();
+    return stats;
+}
@@ -0,0 +1,80 @@
+#ifndef _SELF_PLAY_
+    #define _SELF_PLAY_
+#include "SessionArchive.hpp"
+#include "Simulation.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Decides what a headless player does. One instance plays one game, so a
+// policy may keep per-game state (a planned path, its own RNG...).
+class MovePolicy {
+    public:
+        virtual ~MovePolicy() {}
+        // called once per frame, before gravity is applied
+        virtual Simulation::Action chooseAction(const Simulation &simulation) = 0;
+};
+
+using PolicyFactory = std::function<std::unique_ptr<MovePolicy>(uint64_t seed)>;
+
+// Picks a random rotation and column for every piece, walks there and hard drops.
+class RandomPlacementPolicy : public MovePolicy {
+    public:
+        explicit RandomPlacementPolicy(uint64_t seed);
+        Simulation::Action chooseAction(const Simulation &simulation) override;
+
+    private:
+        uint64_t state;
+        int plannedPiece;
+        int targetX;
+        int rotationsLeft;
+
+        uint32_t nextRandom();
+};
+
+struct GameResult {
+    uint64_t seed;
+    int score;
+    int level;
+    int lines;
+    int pieces;
+    uint64_t ticks;
+};
+
+struct BatchStats {
+    int games;
+    long long totalScore;
+    long long totalLines;
+    long long totalPieces;
+    int bestScore;
+    double seconds;
+
+    double piecesPerSecond() const { return seconds > 0 ? totalPieces / seconds : 0.0; }
+};
+
+// Plays many independent games across a thread pool, one RNG stream per game.
+class SelfPlayRunner {
+    public:
+        explicit SelfPlayRunner(int threads = 0);
+
+        // maxPieces <= 0 lets every game run until it tops out
+        BatchStats run(int games, uint64_t seed, const PolicyFactory &makePolicy, int maxPieces = 0,
+                       std::vector<GameResult> *results = nullptr);
+        int threadCount() const { return pool.size(); }
+        void setRandomizerMode(Randomizer::Mode mode) { randomizerMode = mode; }
+        // every game played is appended there, nullptr (the default) for none
+        void setArchive(SessionArchiveWriter *writer) { archive = writer; }
+
+        static uint64_t gameSeed(uint64_t batchSeed, int game);
+        // archive, when given, gets the game and every piece it placed
+        static GameResult playGame(uint64_t seed, Randomizer::Mode mode, MovePolicy &policy, int maxPieces,
+                                   SessionArchiveWriter *archive = nullptr);
+
+    private:
+        ThreadPool pool;
+        Randomizer::Mode randomizerMode;
+        SessionArchiveWriter *archive;
+};
+
+#endif /* _SELF_PLAY_ */
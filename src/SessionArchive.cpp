@@ -0,0 +1,237 @@
+#include "SessionArchive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "archives are stored little-endian");
+static_assert(sizeof(SessionArchive::Entry) == 48, "index entries changed size");
+
+namespace {
+    const char DATA_MAGIC[4] = { 'T', 'S', 'A', '1' };
+    const char INDEX_MAGIC[4] = { 'T', 'S', 'I', '1' };
+    const size_t HEADER_SIZE = 8;
+    // lowest x and y a piece origin can lock at (the shape starts inside its 5x5 box)
+    const int POSITION_BIAS = 4;
+
+    // whole file mapped read-only, nullptr when empty or on failure
+    const uint8_t *mapFile(const std::string &path, size_t &size) {
+        size = 0;
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Failed to open archive file " << path << std::endl;
+            return nullptr;
+        }
+        struct stat info;
+        void *mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                size = static_cast<size_t>(info.st_size);
+                // scans go front to back, let the kernel read ahead
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Failed to map archive file " << path << std::endl;
+            return nullptr;
+        }
+        return static_cast<const uint8_t *>(mapped);
+    }
+
+    bool hasMagic(const uint8_t *file, size_t size, const char (&magic)[4]) {
+        return size >= HEADER_SIZE && std::memcmp(file, magic, sizeof(magic)) == 0;
+    }
+
+    // size of an existing file, 0 when it does not exist yet
+    uint64_t fileSize(const std::string &path) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        return error ? 0 : size;
+    }
+
+    // how many entries from the first describe the data: each game right
+    // after the one before it, all inside the data file. end is set to
+    // where the last of them stops.
+    size_t countValid(const SessionArchive::Entry *entries, size_t count, uint64_t dataSize, uint64_t &end) {
+        end = HEADER_SIZE;
+        for (size_t i = 0; i < count; ++i) {
+            const SessionArchive::Entry &entry = entries[i];
+            if (entry.pieces < 0 || entry.offset != end ||
+                entry.offset + static_cast<uint64_t>(entry.pieces) * sizeof(uint16_t) > dataSize)
+                return i;
+            end += static_cast<uint64_t>(entry.pieces) * sizeof(uint16_t);
+        }
+        return count;
+    }
+
+    bool readMagic(const std::string &path, const char (&magic)[4]) {
+        char header[sizeof(magic)];
+        std::ifstream file(path, std::ios::binary);
+        return file.read(header, sizeof(header)) && std::memcmp(header, magic, sizeof(magic)) == 0;
+    }
+}
+
+SessionArchive::SessionArchive() : data(nullptr), dataSize(0), index(nullptr), indexSize(0), entries(nullptr), entryCount(0) {}
+
+SessionArchive::~SessionArchive() {
+    close();
+}
+
+bool SessionArchive::open(const std::string &path) {
+    close();
+    data = mapFile(path, dataSize);
+    index = data ? mapFile(indexPath(path), indexSize) : nullptr;
+    if (!data || !index) {
+        close();
+        return false;
+    }
+    uint32_t entrySize = 0;
+    if (hasMagic(index, indexSize, INDEX_MAGIC))
+        std::memcpy(&entrySize, index + sizeof(INDEX_MAGIC), sizeof(entrySize));
+    if (!hasMagic(data, dataSize, DATA_MAGIC) || entrySize != sizeof(Entry)) {
+        std::cerr << "Not a session archive: " << path << std::endl;
+        close();
+        return false;
+    }
+
+    // the header keeps the entries 8-byte aligned in the page-aligned mapping
+    entries = reinterpret_cast<const Entry *>(index + HEADER_SIZE);
+    // every entry is checked, the first one that does not match the data
+    // (lost or overwritten) ends the archive; the writer trims it the same way
+    uint64_t end;
+    entryCount = countValid(entries, (indexSize - HEADER_SIZE) / sizeof(Entry), dataSize, end);
+    return true;
+}
+
+void SessionArchive::close() {
+    if (data)
+        munmap(const_cast<uint8_t *>(data), dataSize);
+    if (index)
+        munmap(const_cast<uint8_t *>(index), indexSize);
+    data = index = nullptr;
+    dataSize = indexSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+}
+
+const uint16_t *SessionArchive::getPlacements(size_t i) const {
+    return reinterpret_cast<const uint16_t *>(data + entries[i].offset);
+}
+
+uint16_t SessionArchive::encode(const Simulation::Placement &placement) {
+    return static_cast<uint16_t>(placement.piece.getTetromino() |
+                                 placement.piece.getRotation() << 3 |
+                                 (placement.x + POSITION_BIAS) << 5 |
+                                 (placement.y + POSITION_BIAS) << 9);
+}
+
+Simulation::Placement SessionArchive::decode(uint16_t packed) {
+    Piece piece(static_cast<Piece::Tetromino>(packed & 0x7));
+    for (int i = (packed >> 3) & 0x3; i > 0; --i)
+        piece.rotate();
+    return { piece, static_cast<int8_t>(((packed >> 5) & 0xF) - POSITION_BIAS),
+             static_cast<int8_t>(((packed >> 9) & 0x1F) - POSITION_BIAS) };
+}
+
+std::string SessionArchive::indexPath(const std::string &path) {
+    return path + ".idx";
+}
+
+SessionArchiveWriter::SessionArchiveWriter(const std::string &path) : dataSize(0), open(false) {
+    std::string index = SessionArchive::indexPath(path);
+    dataSize = fileSize(path);
+    uint64_t indexSize = fileSize(index);
+    if ((dataSize > 0 && !readMagic(path, DATA_MAGIC)) || (indexSize > 0 && !readMagic(index, INDEX_MAGIC))) {
+        std::cerr << "Not a session archive: " << path << std::endl;
+        return;
+    }
+    // Entries that no longer match the data (a crash between the two
+    // writes, a half-written entry, a data file cut short) are dropped with
+    // everything after them, and so are data bytes no entry points at, so
+    // the next game is appended right after the last good one.
+    if (indexSize > 0 || dataSize > HEADER_SIZE) {
+        std::vector<SessionArchive::Entry> entries;
+        if (indexSize > HEADER_SIZE) {
+            entries.resize((indexSize - HEADER_SIZE) / sizeof(SessionArchive::Entry));
+            std::ifstream file(index, std::ios::binary);
+            file.seekg(HEADER_SIZE);
+            file.read(reinterpret_cast<char *>(entries.data()),
+                      static_cast<std::streamsize>(entries.size() * sizeof(SessionArchive::Entry)));
+            if (!file) {
+                std::cerr << "Failed to read session archive index " << index << std::endl;
+                return;
+            }
+        }
+        uint64_t end;
+        size_t valid = countValid(entries.data(), entries.size(), dataSize, end);
+        std::error_code error;
+        if (valid < entries.size())
+            std::cerr << "Session archive " << path << ": dropping " << entries.size() - valid
+                      << " games whose data is missing" << std::endl;
+        if (indexSize > HEADER_SIZE + valid * sizeof(SessionArchive::Entry))
+            std::filesystem::resize_file(index, HEADER_SIZE + valid * sizeof(SessionArchive::Entry), error);
+        if (!error && dataSize > end) {
+            std::filesystem::resize_file(path, end, error);
+            dataSize = end;
+        }
+        if (error) {
+            std::cerr << "Failed to repair session archive " << path << ": " << error.message() << std::endl;
+            return;
+        }
+    }
+
+    dataFile.open(path, std::ios::binary | std::ios::app);
+    indexFile.open(index, std::ios::binary | std::ios::app);
+    if (!dataFile || !indexFile) {
+        std::cerr << "Failed to open session archive " << path << std::endl;
+        return;
+    }
+    if (dataSize == 0) {
+        const char header[HEADER_SIZE] = { DATA_MAGIC[0], DATA_MAGIC[1], DATA_MAGIC[2], DATA_MAGIC[3] };
+        dataFile.write(header, sizeof(header));
+        dataSize = sizeof(header);
+    }
+    if (indexSize == 0) {
+        char header[HEADER_SIZE];
+        uint32_t entrySize = sizeof(SessionArchive::Entry);
+        std::memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        std::memcpy(header + sizeof(INDEX_MAGIC), &entrySize, sizeof(entrySize));
+        indexFile.write(header, sizeof(header));
+    }
+    open = dataFile.flush() && indexFile.flush();
+}
+
+bool SessionArchiveWriter::append(const Simulation &simulation, const std::vector<uint16_t> &placements) {
+    if (!open)
+        return false;
+
+    SessionArchive::Entry entry = {};
+    entry.seed = simulation.getRandomizer().getSeed();
+    entry.mode = static_cast<uint8_t>(simulation.getRandomizer().getMode());
+    entry.ticks = simulation.getTickCount();
+    entry.score = simulation.getBoard().getScore();
+    entry.level = simulation.getBoard().getLevel();
+    entry.lines = simulation.getTotalLines();
+    entry.pieces = static_cast<int32_t>(placements.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entry.offset = dataSize;
+    dataFile.write(reinterpret_cast<const char *>(placements.data()),
+                   static_cast<std::streamsize>(placements.size() * sizeof(uint16_t)));
+    dataFile.flush();
+    indexFile.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    indexFile.flush();
+    if (!dataFile || !indexFile) {
+        std::cerr << "Failed to write to the session archive" << std::endl;
+        open = false;
+        return false;
+    }
+    dataSize += placements.size() * sizeof(uint16_t);
+    return true;
+}
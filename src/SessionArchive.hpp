@@ -0,0 +1,88 @@
+#ifndef _SESSION_ARCHIVE_
+    #define _SESSION_ARCHIVE_
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Finished games, appended one after the other for offline analysis. Two
+// files, both append-only:
+//  - <path>: "TSA1" + 4 zero bytes, then for each game one uint16 per
+//    piece placed (SessionArchive::encode);
+//  - <path>.idx: "TSI1" + uint32 entry size, then one fixed-size Entry per
+//    game pointing at its placements.
+// Both are written in the machine byte order (little-endian everywhere
+// we build) and read back through mmap without any copy or parsing.
+class SessionArchive {
+    public:
+        struct Entry {
+            uint64_t offset;        // of the placements in the data file
+            uint64_t seed;
+            uint64_t ticks;
+            int32_t score;
+            int32_t level;
+            int32_t lines;
+            int32_t pieces;         // number of placements
+            uint8_t mode;           // Randomizer::Mode
+            uint8_t reserved[7];
+        };
+
+        SessionArchive();
+        ~SessionArchive();
+
+        SessionArchive(const SessionArchive &) = delete;
+        SessionArchive &operator=(const SessionArchive &) = delete;
+
+        // maps both files read-only; false (and a message on std::cerr)
+        // when they cannot be read or are not an archive. Every entry is
+        // checked against the data: the first one whose placements are not
+        // right after the previous game's, inside the data file, ends the
+        // archive (a game cut short by a crash, a truncated data file).
+        bool open(const std::string &path);
+        void close();
+
+        size_t size() const { return entryCount; }
+        const Entry &getEntry(size_t i) const { return entries[i]; }
+        // getEntry(i).pieces placements, straight from the mapping
+        const uint16_t *getPlacements(size_t i) const;
+
+        // 3 bits of type, 2 of rotation, x + 4 on 4 bits and y + 4 on 5
+        static uint16_t encode(const Simulation::Placement &placement);
+        static Simulation::Placement decode(uint16_t packed);
+        static std::string indexPath(const std::string &path);
+
+    private:
+        const uint8_t *data;
+        size_t dataSize;
+        const uint8_t *index;
+        size_t indexSize;
+        const Entry *entries;
+        size_t entryCount;
+};
+
+// Appends finished games to an archive, creating it when missing. Several
+// threads may append at once. Opening it first trims what open() would
+// not read, so new games follow the last good one.
+class SessionArchiveWriter {
+    public:
+        explicit SessionArchiveWriter(const std::string &path);
+
+        bool isOpen() const { return open; }
+        // the game as it ended and the placements collected while it played.
+        // The data is written before the index entry that points at it, but
+        // nothing is fsynced: after a power loss the last games may be gone
+        // or their entries dropped when their data did not make it.
+        bool append(const Simulation &simulation, const std::vector<uint16_t> &placements);
+
+    private:
+        std::mutex mutex;
+        std::ofstream dataFile;
+        std::ofstream indexFile;
+        uint64_t dataSize;
+        bool open;
+};
+
+#endif /* _SESSION_ARCHIVE_ */
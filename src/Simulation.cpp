@@ -0,0 +1,236 @@
+#include "Simulation.hpp"
+#include "Zobrist.hpp"
+#include <type_traits>
+
+static_assert(NEXT_PIECE_COUNT <= Zobrist::MAX_QUEUE, "not enough Zobrist keys for the preview queue");
+static_assert(std::is_trivially_copyable<Simulation::Snapshot>::value, "snapshots must stay plain bytes");
+static_assert(sizeof(Simulation::Snapshot) <= 512, "snapshot grew past a few hundred bytes");
+static_assert(Board::WIDTH <= INT8_MAX && Board::HEIGHT <= INT8_MAX, "piece position no longer fits a snapshot");
+
+Simulation::Simulation(uint64_t seed, Randomizer::Mode mode) : randomizer(seed, mode), currentPiece(Piece::I), heldPiece(Piece::I),
+             lastPlacement{Piece(Piece::I), 0, 0},
+             hasHeldPiece(false), canHold(true), pieceX(SPAWN_X), pieceY(SPAWN_Y), gameOver(false),
+             gravityFrames(0), tickCount(0), pieceCount(0), totalLines(0),
+             pieceVersion(0), queueVersion(0), holdVersion(0) {
+    for (auto &piece : nextPieces) {
+        piece = Piece(randomizer.next());
+    }
+    spawnNewPiece();
+}
+
+uint64_t Simulation::getHash() const {
+    // the board keeps its own hash up to date, the pieces are only a few keys
+    uint64_t hash = board.getHash()
+                  ^ Zobrist::piece(Zobrist::ACTIVE, currentPiece.getTetromino())
+                  ^ Zobrist::placement(currentPiece.getRotation(), pieceX, pieceY);
+    if (hasHeldPiece)
+        hash ^= Zobrist::held(heldPiece.getTetromino(), heldPiece.getRotation());
+    if (!canHold)
+        hash ^= Zobrist::holdUsed();
+    for (int i = 0; i < NEXT_PIECE_COUNT; ++i)
+        hash ^= Zobrist::piece(Zobrist::QUEUE + i, nextPieces[i].getTetromino());
+    return hash;
+}
+
+Simulation::Snapshot Simulation::snapshot() const {
+    Snapshot saved;
+    saved.board = board.snapshot();
+    saved.randomizer = randomizer.snapshot();
+    saved.tickCount = tickCount;
+    saved.gravityFrames = gravityFrames;
+    saved.pieceCount = pieceCount;
+    saved.totalLines = totalLines;
+    saved.pieceX = static_cast<int8_t>(pieceX);
+    saved.pieceY = static_cast<int8_t>(pieceY);
+    saved.currentPiece = currentPiece;
+    saved.nextPieces = nextPieces;
+    saved.heldPiece = heldPiece;
+    saved.lastPlacement = lastPlacement;
+    saved.hasHeldPiece = hasHeldPiece;
+    saved.canHold = canHold;
+    saved.gameOver = gameOver;
+    return saved;
+}
+
+void Simulation::restore(const Snapshot &saved) {
+    board.restore(saved.board);
+    randomizer.restore(saved.randomizer);
+    tickCount = saved.tickCount;
+    gravityFrames = saved.gravityFrames;
+    pieceCount = saved.pieceCount;
+    totalLines = saved.totalLines;
+    pieceX = saved.pieceX;
+    pieceY = saved.pieceY;
+    currentPiece = saved.currentPiece;
+    nextPieces = saved.nextPieces;
+    heldPiece = saved.heldPiece;
+    lastPlacement = saved.lastPlacement;
+    hasHeldPiece = saved.hasHeldPiece;
+    canHold = saved.canHold;
+    gameOver = saved.gameOver;
+    pieceVersion++;
+    queueVersion++;
+    holdVersion++;
+}
+
+int Simulation::getFramesPerCell() const {
+    int level = board.getLevel();
+
+    if (level == 0) return 48;
+    else if (level == 1) return 43;
+    else if (level == 2) return 38;
+    else if (level == 3) return 33;
+    else if (level == 4) return 28;
+    else if (level == 5) return 23;
+    else if (level == 6) return 18;
+    else if (level == 7) return 13;
+    else if (level == 8) return 8;
+    else if (level == 9) return 6;
+    else if (level >= 10 && level <= 12) return 5;
+    else if (level >= 13 && level <= 15) return 4;
+    else if (level >= 16 && level <= 18) return 3;
+    else if (level >= 19 && level <= 28) return 2;
+    else return 1; // level 29+
+}
+
+int Simulation::tick() {
+    if (gameOver)
+        return EVENT_NONE;
+
+    tickCount++;
+    if (++gravityFrames < getFramesPerCell())
+        return EVENT_NONE;
+    gravityFrames = 0;
+
+    if (board.isValidPosition(currentPiece, pieceX, pieceY + 1)) {
+        pieceY++;
+        pieceVersion++;
+        return EVENT_NONE;
+    }
+    return lockPiece();
+}
+
+int Simulation::step(Action action) {
+    if (gameOver)
+        return EVENT_NONE;
+
+    switch (action) {
+        case MOVE_LEFT:
+            if (board.isValidPosition(currentPiece, pieceX - 1, pieceY)) {
+                pieceX--;
+                pieceVersion++;
+            }
+            break;
+        case MOVE_RIGHT:
+            if (board.isValidPosition(currentPiece, pieceX + 1, pieceY)) {
+                pieceX++;
+                pieceVersion++;
+            }
+            break;
+        case SOFT_DROP:
+            if (board.isValidPosition(currentPiece, pieceX, pieceY + 1)) {
+                pieceY++;
+                pieceVersion++;
+            }
+            board.setScore(board.getScore() + 1);
+            break;
+        case ROTATE:
+            if (!rotatePiece(board, currentPiece, pieceX, pieceY))
+                break;
+            pieceVersion++;
+            return EVENT_ROTATE;
+        case HARD_DROP:
+            pieceY = board.findDropPosition(currentPiece, pieceX, pieceY);
+            return lockPiece();
+        case HOLD:
+            return holdPiece();
+        case NONE:
+            break;
+    }
+    return EVENT_NONE;
+}
+
+int Simulation::lockPiece() {
+    int events = EVENT_PLACE;
+    int lines = board.placePiece(currentPiece, pieceX, pieceY);
+    lastPlacement = { currentPiece, static_cast<int8_t>(pieceX), static_cast<int8_t>(pieceY) };
+
+    pieceCount++;
+    if (lines > 0) {
+        totalLines += lines;
+        events |= EVENT_LINE_CLEAR;
+    }
+    return events | spawnNewPiece();
+}
+
+int Simulation::spawnNewPiece() {
+    pieceX = SPAWN_X;
+    pieceY = SPAWN_Y;
+    gravityFrames = 0;
+
+    currentPiece = nextPieces[0];
+    for (int i = 0; i < NEXT_PIECE_COUNT - 1; i++) {
+        nextPieces[i] = nextPieces[i + 1];
+    }
+    nextPieces[NEXT_PIECE_COUNT - 1] = Piece(randomizer.next());
+    pieceVersion++;
+    queueVersion++;
+
+    canHold = true;
+
+    if (!board.isValidPosition(currentPiece, pieceX, pieceY)) {
+        gameOver = true;
+        return EVENT_GAME_OVER;
+    }
+    return EVENT_NONE;
+}
+
+int Simulation::holdPiece() {
+    if (!canHold)
+        return EVENT_NONE;
+
+    int events = EVENT_NONE;
+    if (!hasHeldPiece) {
+        heldPiece = currentPiece;
+        hasHeldPiece = true;
+        events = spawnNewPiece();
+    } else {
+        Piece tempPiece = currentPiece;
+        currentPiece = heldPiece;
+        heldPiece = tempPiece;
+
+        pieceX = SPAWN_X;
+        pieceY = SPAWN_Y;
+        gravityFrames = 0;
+        pieceVersion++;
+
+        if (!board.isValidPosition(currentPiece, pieceX, pieceY)) {
+            gameOver = true;
+            events = EVENT_GAME_OVER;
+        }
+    }
+
+    canHold = false;
+    holdVersion++;
+    return events;
+}
+
+bool Simulation::rotatePiece(const Board &board, Piece &piece, int &x, int &y) {
+    Piece rotated = piece;
+
+    rotated.rotate();
+    if (board.isValidPosition(rotated, x, y)) {
+        piece = rotated;
+        return true;
+    }
+    for (const Kick &kick : WALL_KICKS) {
+        if (board.isValidPosition(rotated, x + kick.x, y + kick.y)) {
+            piece = rotated;
+            x += kick.x;
+            y += kick.y;
+            return true;
+        }
+    }
+    // pas de position valide
+    return false;
+}
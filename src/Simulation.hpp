@@ -0,0 +1,155 @@
+#ifndef _SIMULATION_
+    #define _SIMULATION_
+#include "Board.hpp"
+#include "Piece.hpp"
+#include "Randomizer.hpp"
+#include <array>
+#include <cstdint>
+#define NEXT_PIECE_COUNT 4
+
+// Game rules without any SDL dependency: board, active piece, preview queue,
+// hold slot, scoring and gravity counted in frames. Game drives it from
+// keyboard input and wall clock time; tools drive it directly.
+class Simulation {
+    public:
+        enum Action {
+            NONE,
+            MOVE_LEFT,
+            MOVE_RIGHT,
+            SOFT_DROP,
+            ROTATE,
+            HARD_DROP,
+            HOLD
+        };
+
+        // bit flags returned by step() and tick() so the front end can
+        // play sounds without the rules knowing about audio
+        enum Event {
+            EVENT_NONE       = 0,
+            EVENT_ROTATE     = 1 << 0,
+            EVENT_PLACE      = 1 << 1,
+            EVENT_LINE_CLEAR = 1 << 2,
+            EVENT_GAME_OVER  = 1 << 3
+        };
+
+        using Queue = std::array<Piece, NEXT_PIECE_COUNT>;
+
+        // a piece where it locked
+        struct Placement {
+            Piece piece;
+            int8_t x, y;
+        };
+
+        // The whole game at one tick in a few hundred plain bytes: saving
+        // and restoring are a copy, nothing is allocated. Only meant to be
+        // restored into a Simulation of the same game (same seed).
+        struct Snapshot {
+            Board::Snapshot board;
+            Randomizer::State randomizer;
+            uint64_t tickCount;
+            int32_t gravityFrames;
+            int32_t pieceCount;
+            int32_t totalLines;
+            int8_t pieceX, pieceY;
+            Piece currentPiece;
+            Queue nextPieces;
+            Piece heldPiece;
+            Placement lastPlacement;
+            bool hasHeldPiece;
+            bool canHold;
+            bool gameOver;
+        };
+
+        static constexpr int SPAWN_X = (Board::WIDTH / 2) - 2;
+        static constexpr int SPAWN_Y = 0;
+
+        // offsets tried in order when a rotation does not fit in place,
+        // shared with the move generator so bots see the same spins
+        struct Kick {
+            int8_t x;
+            int8_t y;
+        };
+        static constexpr int KICK_COUNT = 8;
+        // define tout les offests de wall kicks
+        static constexpr std::array<Kick, KICK_COUNT> WALL_KICKS = {{
+            {-1, 0},  // gauche
+            {1, 0},   // droite
+            {-2, 0},  // 2 a gauche
+            {2, 0},   // 2 a droite
+            {0, -1},  // en haut
+            {0, 1},   // en bas
+            {-1, -1}, // en haut a gauche
+            {1, -1}   // en haut a droite
+        }};
+
+        // rotates piece at (x, y) on board, trying WALL_KICKS when it does not
+        // fit in place; leaves everything untouched and returns false when
+        // no position fits. The ROTATE rule, shared with the autoplayer.
+        static bool rotatePiece(const Board &board, Piece &piece, int &x, int &y);
+
+        explicit Simulation(uint64_t seed, Randomizer::Mode mode = Randomizer::PURE_RANDOM);
+
+        int step(Action action);
+        int tick();
+
+        const Board &getBoard() const { return board; }
+        const Piece &getCurrentPiece() const { return currentPiece; }
+        int getPieceX() const { return pieceX; }
+        int getPieceY() const { return pieceY; }
+        const Queue &getNextPieces() const { return nextPieces; }
+        const Piece *getHeldPiece() const { return hasHeldPiece ? &heldPiece : nullptr; }
+        bool canHoldPiece() const { return canHold; }
+        bool isGameOver() const { return gameOver; }
+        const Randomizer &getRandomizer() const { return randomizer; }
+        // the piece locked by the last EVENT_PLACE
+        const Placement &getLastPlacement() const { return lastPlacement; }
+
+        uint64_t getTickCount() const { return tickCount; }
+        int getPieceCount() const { return pieceCount; }
+        int getTotalLines() const { return totalLines; }
+        int getFramesPerCell() const;
+
+        // bumped whenever the active piece moves, the queue shifts or the
+        // hold slot changes (see Board for the cells and score counters)
+        uint32_t getPieceVersion() const { return pieceVersion; }
+        uint32_t getQueueVersion() const { return queueVersion; }
+        uint32_t getHoldVersion() const { return holdVersion; }
+
+        // Zobrist hash of everything the next moves depend on: the board
+        // cells, the active piece and where it stands, the held piece (and
+        // whether it can be swapped) and the preview queue
+        uint64_t getHash() const;
+
+        Snapshot snapshot() const;
+        // back to the saved tick; every version is bumped so the renderer
+        // redraws everything
+        void restore(const Snapshot &saved);
+
+    private:
+        Randomizer randomizer;
+
+        Board board;
+        Piece currentPiece;
+        Queue nextPieces;
+        Piece heldPiece;
+        Placement lastPlacement;
+        bool hasHeldPiece;
+        bool canHold;
+        int pieceX, pieceY;
+        bool gameOver;
+
+        int gravityFrames;
+        uint64_t tickCount;
+        int pieceCount;
+        int totalLines;
+
+        uint32_t pieceVersion;
+        uint32_t queueVersion;
+        uint32_t holdVersion;
+
+        int lockPiece();
+        int spawnNewPiece();
+        int holdPiece();
+};
+
+#endif /* _SIMULATION_ */
@@ -0,0 +1,66 @@
+#include "SoundMixer.hpp"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+SoundMixer::SoundMixer() : volume(128), frame(0) {
+    voices.fill({ nullptr, 0, 0, false });
+}
+
+void SoundMixer::setSound(int voice, const int16_t *samples, size_t frames) {
+    if (voice >= 0 && voice < SOUND_MIXER_VOICES)
+        voices[voice] = { samples, frames, 0, false };
+}
+
+void SoundMixer::setVolume(int newVolume) {
+    volume.store(std::max(0, std::min(128, newVolume)), std::memory_order_relaxed);
+}
+
+void SoundMixer::trigger(int voice, uint64_t at) {
+    if (voice < 0 || voice >= SOUND_MIXER_VOICES || !voices[voice].samples)
+        return;
+    voices[voice].start = std::max(at, frame);
+    voices[voice].playing = true;
+}
+
+void SoundMixer::mix(int16_t *out, size_t frames) {
+    int gain = volume.load(std::memory_order_relaxed);
+    uint64_t end = frame + frames;
+
+    for (Voice &voice : voices) {
+        if (!voice.playing || voice.start >= end)
+            continue;
+        // the part of the voice that falls in [frame, end)
+        size_t offset = voice.start > frame ? static_cast<size_t>(voice.start - frame) : 0;
+        size_t played = static_cast<size_t>(frame + offset - voice.start);
+        size_t count = std::min(frames - offset, voice.frames - played);
+        if (gain > 0)
+            mixSamples(out + offset * 2, voice.samples + played * 2, count * 2, gain);
+        if (played + count >= voice.frames)
+            voice.playing = false;
+    }
+    frame = end;
+}
+
+void SoundMixer::mixSamples(int16_t *out, const int16_t *in, size_t count, int gain) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    // (out * 128 + in * gain) >> 7 in 32 bits with one madd per 4 samples:
+    // interleaving out and in pairs each sample with its weight, packs
+    // saturates back to 16 bits
+    const __m128i weights = _mm_set1_epi32((gain << 16) | 128);
+    for (; i + 8 <= count; i += 8) {
+        __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i low = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(o, s), weights), 7);
+        __m128i high = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(o, s), weights), 7);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        int value = (out[i] * 128 + in[i] * gain) >> 7;
+        out[i] = static_cast<int16_t>(std::max(-32768, std::min(32767, value)));
+    }
+}
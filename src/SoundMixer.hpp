@@ -0,0 +1,48 @@
+#ifndef _SOUND_MIXER_
+    #define _SOUND_MIXER_
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+// one voice per sound effect
+#define SOUND_MIXER_VOICES 4
+
+// Mixes short 16-bit stereo sounds into an output buffer, each voice
+// starting on the exact frame it was scheduled for rather than at the next
+// buffer. No SDL in here: AudioManager feeds it from the audio callback,
+// which is the only thread calling trigger() and mix().
+class SoundMixer {
+    public:
+        SoundMixer();
+
+        // samples: interleaved stereo, frames of 2 samples; must outlive the mixer
+        void setSound(int voice, const int16_t *samples, size_t frames);
+        // 0-128 like SDL_mixer, any thread
+        void setVolume(int volume);
+
+        // plays voice from its start at output frame `frame` (frames count
+        // from the first mix()); a frame already mixed starts it at once,
+        // triggering a playing voice restarts it
+        void trigger(int voice, uint64_t frame);
+        // adds every playing voice to out, frames stereo frames
+        void mix(int16_t *out, size_t frames);
+        // frames mixed so far, the frame the next mix() starts at
+        uint64_t getFrame() const { return frame; }
+
+        // out[i] = saturate(out[i] + in[i] * volume / 128), SSE2 when available
+        static void mixSamples(int16_t *out, const int16_t *in, size_t count, int volume);
+
+    private:
+        struct Voice {
+            const int16_t *samples;
+            size_t frames;
+            uint64_t start;
+            bool playing;
+        };
+
+        std::array<Voice, SOUND_MIXER_VOICES> voices;
+        std::atomic<int> volume;
+        uint64_t frame;
+};
+
+#endif /* _SOUND_MIXER_ */
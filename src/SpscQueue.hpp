@@ -0,0 +1,79 @@
+#ifndef _SPSC_QUEUE_
+    #define _SPSC_QUEUE_
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded queue for exactly one producer thread and one consumer thread,
+// without locks: each side only writes its own index and reads the
+// other's. Capacity must be a power of two; push() fails when full
+// instead of waiting. The bulk versions move as many items as fit in one
+// go, for sample streams.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        SpscQueue() : head(0), tail(0) {}
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // producer side
+        bool push(const T &value) {
+            size_t back = tail.load(std::memory_order_relaxed);
+            if (back - head.load(std::memory_order_acquire) == Capacity)
+                return false;
+            items[back & (Capacity - 1)] = value;
+            tail.store(back + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side
+        bool pop(T &value) {
+            size_t front = head.load(std::memory_order_relaxed);
+            if (front == tail.load(std::memory_order_acquire))
+                return false;
+            value = items[front & (Capacity - 1)];
+            head.store(front + 1, std::memory_order_release);
+            return true;
+        }
+
+        // producer side, returns how many of the count values went in
+        size_t push(const T *values, size_t count) {
+            size_t back = tail.load(std::memory_order_relaxed);
+            count = std::min(count, Capacity - (back - head.load(std::memory_order_acquire)));
+            size_t offset = back & (Capacity - 1);
+            size_t first = std::min(count, Capacity - offset);
+            std::copy(values, values + first, items.begin() + offset);
+            std::copy(values + first, values + count, items.begin());
+            tail.store(back + count, std::memory_order_release);
+            return count;
+        }
+
+        // consumer side, returns how many values were read
+        size_t pop(T *values, size_t count) {
+            size_t front = head.load(std::memory_order_relaxed);
+            count = std::min(count, tail.load(std::memory_order_acquire) - front);
+            size_t offset = front & (Capacity - 1);
+            size_t first = std::min(count, Capacity - offset);
+            std::copy(items.begin() + offset, items.begin() + offset + first, values);
+            std::copy(items.begin(), items.begin() + (count - first), values + first);
+            head.store(front + count, std::memory_order_release);
+            return count;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        // the two indices on their own cache lines, producer and consumer
+        // never bounce a line they both write
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) std::array<T, Capacity> items;
+};
+
+#endif /* _SPSC_QUEUE_ */
@@ -0,0 +1,136 @@
+#include "ThreadPool.hpp"
+
+namespace {
+    inline uint64_t pack(uint32_t begin, uint32_t end) {
+        return (static_cast<uint64_t>(end) << 32) | begin;
+    }
+
+    inline uint32_t rangeBegin(uint64_t range) {
+        return static_cast<uint32_t>(range);
+    }
+
+    inline uint32_t rangeEnd(uint64_t range) {
+        return static_cast<uint32_t>(range >> 32);
+    }
+}
+
+ThreadPool::ThreadPool(int threads) : task(nullptr), generation(0), running(0), stopping(false) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0)
+            threads = 1;
+    }
+    slices.reset(new Slice[threads]);
+    for (int i = 0; i < threads; ++i) {
+        slices[i].range.store(0);
+    }
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const Task &fn) {
+    if (count <= 0)
+        return;
+
+    int threads = size();
+    std::unique_lock<std::mutex> lock(mutex);
+    for (int i = 0; i < threads; ++i) {
+        uint32_t begin = static_cast<uint32_t>(static_cast<int64_t>(count) * i / threads);
+        uint32_t end = static_cast<uint32_t>(static_cast<int64_t>(count) * (i + 1) / threads);
+        slices[i].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+    task = &fn;
+    running = threads;
+    generation++;
+    wakeUp.notify_all();
+    finished.wait(lock, [this] { return running == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker) {
+    uint64_t seen = 0;
+
+    for (;;) {
+        const Task *job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            job = task;
+        }
+
+        int index;
+        while (popLocal(worker, index) || steal(worker, index)) {
+            (*job)(index, worker);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0)
+            finished.notify_one();
+    }
+}
+
+bool ThreadPool::popLocal(int worker, int &index) {
+    std::atomic<uint64_t> &range = slices[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+
+    while (rangeBegin(current) < rangeEnd(current)) {
+        uint64_t next = pack(rangeBegin(current) + 1, rangeEnd(current));
+        if (range.compare_exchange_weak(current, next, std::memory_order_acq_rel)) {
+            index = static_cast<int>(rangeBegin(current));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::steal(int worker, int &index) {
+    int threads = size();
+
+    for (;;) {
+        // pick the victim with the most work left
+        int victim = -1;
+        uint32_t best = 0;
+        for (int i = 1; i < threads; ++i) {
+            int candidate = (worker + i) % threads;
+            uint64_t range = slices[candidate].range.load(std::memory_order_acquire);
+            uint32_t left = rangeEnd(range) - rangeBegin(range);
+            if (rangeBegin(range) < rangeEnd(range) && left > best) {
+                best = left;
+                victim = candidate;
+            }
+        }
+        if (victim < 0)
+            return false;
+
+        std::atomic<uint64_t> &range = slices[victim].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        uint32_t begin = rangeBegin(current);
+        uint32_t end = rangeEnd(current);
+        if (begin >= end)
+            continue;
+
+        // take the upper half, keep the first index of it for ourselves
+        uint32_t mid = begin + (end - begin) / 2;
+        if (!range.compare_exchange_strong(current, pack(begin, mid), std::memory_order_acq_rel))
+            continue;
+        slices[worker].range.store(pack(mid + 1, end), std::memory_order_release);
+        index = static_cast<int>(mid);
+        return true;
+    }
+}
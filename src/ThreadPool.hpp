@@ -0,0 +1,54 @@
+#ifndef _THREAD_POOL_
+    #define _THREAD_POOL_
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running parallelFor() jobs. Each worker starts
+// with its own slice of the index range and, once it runs dry, steals half
+// of the largest remaining slice from another worker, so uneven work (games
+// of very different length) still keeps every core busy.
+class ThreadPool {
+    public:
+        using Task = std::function<void(int index, int worker)>;
+
+        // threads <= 0 means one per hardware thread
+        explicit ThreadPool(int threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        int size() const { return static_cast<int>(workers.size()); }
+
+        // runs task(i, worker) for every i in [0, count) and waits for completion
+        void parallelFor(int count, const Task &task);
+
+    private:
+        // [begin, end) packed into one word so owner and thieves can CAS it
+        struct alignas(64) Slice {
+            std::atomic<uint64_t> range;
+        };
+
+        std::vector<std::thread> workers;
+        std::unique_ptr<Slice[]> slices;
+
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        std::condition_variable finished;
+        const Task *task;
+        uint64_t generation;
+        int running;
+        bool stopping;
+
+        void workerLoop(int worker);
+        bool popLocal(int worker, int &index);
+        bool steal(int worker, int &index);
+};
+
+#endif /* _THREAD_POOL_ */
@@ -0,0 +1,49 @@
+#include "Timeline.hpp"
+#include <algorithm>
+
+Timeline::Timeline(int interval, size_t capacity)
+    : interval(std::max(interval, 1)), snapshots(std::max<size_t>(capacity, 1)), first(0), count(0) {}
+
+bool Timeline::capture(const Simulation &simulation) {
+    if (count > 0) {
+        const Simulation::Snapshot &last = at(count - 1);
+        if (simulation.getTickCount() <= last.tickCount || simulation.getPieceCount() < last.pieceCount + interval)
+            return false;
+    }
+    if (count < snapshots.size()) {
+        snapshots[(first + count) % snapshots.size()] = simulation.snapshot();
+        count++;
+    } else {
+        // full: the newest takes the place of the oldest
+        snapshots[first] = simulation.snapshot();
+        first = (first + 1) % snapshots.size();
+    }
+    return true;
+}
+
+const Simulation::Snapshot *Timeline::find(uint64_t tick) const {
+    // snapshots are in tick order, binary search for the last one <= tick
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (at(middle).tickCount <= tick)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low > 0 ? &at(low - 1) : nullptr;
+}
+
+const Simulation::Snapshot *Timeline::getOldest() const {
+    return count > 0 ? &at(0) : nullptr;
+}
+
+void Timeline::discardAfter(uint64_t tick) {
+    while (count > 0 && at(count - 1).tickCount > tick)
+        count--;
+}
+
+void Timeline::clear() {
+    first = 0;
+    count = 0;
+}
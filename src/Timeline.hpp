@@ -0,0 +1,48 @@
+#ifndef _TIMELINE_
+    #define _TIMELINE_
+#include "Simulation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// pieces between two snapshots: a seek re-simulates at most this many
+#define TIMELINE_INTERVAL 10
+// snapshots kept, about 90 KB; older ones are overwritten
+#define TIMELINE_CAPACITY 256
+
+// Snapshots of one game taken every few pieces while it plays, in a ring
+// buffer of fixed size. A replay can re-simulate from them, so any tick
+// since the oldest snapshot is one restore plus at most `interval` pieces
+// away (ReplayPlayer::seek). A live game has no inputs to replay and can
+// only go back to a snapshot itself (Game::rewind).
+class Timeline {
+    public:
+        explicit Timeline(int interval = TIMELINE_INTERVAL, size_t capacity = TIMELINE_CAPACITY);
+
+        // saves the simulation when it is interval pieces past the last
+        // snapshot (or when there is none); returns true when it did.
+        // Ticks already covered are skipped, so playing a deterministic game
+        // again after a seek does not duplicate anything.
+        bool capture(const Simulation &simulation);
+        // latest snapshot at or before tick, nullptr when tick is older
+        // than everything kept
+        const Simulation::Snapshot *find(uint64_t tick) const;
+        const Simulation::Snapshot *getOldest() const;
+        // drops the snapshots after tick, once the game went back there and
+        // is played differently
+        void discardAfter(uint64_t tick);
+        void clear();
+
+        size_t size() const { return count; }
+        int getInterval() const { return interval; }
+
+    private:
+        int interval;
+        std::vector<Simulation::Snapshot> snapshots;
+        // oldest snapshot, the newest is count - 1 slots after it
+        size_t first;
+        size_t count;
+
+        const Simulation::Snapshot &at(size_t i) const { return snapshots[(first + i) % snapshots.size()]; }
+};
+
+#endif /* _TIMELINE_ */
@@ -0,0 +1,61 @@
+#include "TranspositionTable.hpp"
+#include <cstring>
+
+namespace {
+    // set in every stored entry so an empty one never matches key 0
+    const uint64_t VALID = 1ULL << 32;
+}
+
+TranspositionTable::TranspositionTable(int sizeBits) {
+    if (sizeBits < 1)
+        sizeBits = 1;
+    if (sizeBits > 30)
+        sizeBits = 30;
+    mask = (1ULL << sizeBits) - 1;
+    entries.reset(new Entry[mask + 1]);
+    clear();
+    resetStats();
+}
+
+bool TranspositionTable::probe(uint64_t key, float &value) {
+    probes.value.fetch_add(1, std::memory_order_relaxed);
+    const Entry &entry = entries[key & mask];
+    uint64_t data = entry.data.load(std::memory_order_relaxed);
+    uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if (!(data & VALID) || (check ^ data) != key)
+        return false;
+
+    uint32_t bits = static_cast<uint32_t>(data);
+    std::memcpy(&value, &bits, sizeof(value));
+    hits.value.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint64_t data = VALID | bits;
+
+    Entry &entry = entries[key & mask];
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+    stores.value.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i <= mask; ++i) {
+        entries[i].check.store(0, std::memory_order_relaxed);
+        entries[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+TranspositionTable::Stats TranspositionTable::getStats() const {
+    return { probes.value.load(std::memory_order_relaxed), hits.value.load(std::memory_order_relaxed),
+             stores.value.load(std::memory_order_relaxed) };
+}
+
+void TranspositionTable::resetStats() {
+    probes.value.store(0, std::memory_order_relaxed);
+    hits.value.store(0, std::memory_order_relaxed);
+    stores.value.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+#ifndef _TRANSPOSITION_TABLE_
+    #define _TRANSPOSITION_TABLE_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Fixed-size cache of position scores keyed by Zobrist hash (Board::getHash,
+// Simulation::getHash), shared by search threads without locks. Each key
+// maps to one slot and a store simply replaces what was there, so memory
+// never grows. An entry is two words written separately with the key
+// stored XORed with the data: a probe racing a store sees a key that does
+// not match and misses, it never returns the score of another position.
+class TranspositionTable {
+    public:
+        struct Stats {
+            uint64_t probes;
+            uint64_t hits;
+            uint64_t stores;
+
+            double hitRate() const { return probes ? static_cast<double>(hits) / probes : 0.0; }
+        };
+
+        // 1 << sizeBits entries of 16 bytes (the default is 4 MB)
+        explicit TranspositionTable(int sizeBits = 18);
+
+        TranspositionTable(const TranspositionTable &) = delete;
+        TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+        // true and value set when key was stored and not replaced since
+        bool probe(uint64_t key, float &value);
+        void store(uint64_t key, float value);
+
+        void clear();
+        size_t size() const { return mask + 1; }
+
+        Stats getStats() const;
+        void resetStats();
+
+    private:
+        struct Entry {
+            std::atomic<uint64_t> check;    // key ^ data
+            std::atomic<uint64_t> data;     // VALID | float bits, 0 when empty
+        };
+
+        // counters on their own cache lines, away from each other and the entries
+        struct alignas(64) Counter {
+            std::atomic<uint64_t> value;
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        uint64_t mask;
+        Counter probes;
+        Counter hits;
+        Counter stores;
+};
+
+#endif /* _TRANSPOSITION_TABLE_ */
@@ -0,0 +1,99 @@
+#ifndef _ZOBRIST_
+    #define _ZOBRIST_
+#include "Piece.hpp"
+#include <array>
+#include <cstdint>
+
+// Random 64-bit keys for Zobrist hashing: a position hashes to the XOR of
+// the keys of what it contains, so adding or removing a cell or a piece is
+// one XOR. The keys are generated at compile time from a fixed seed, hashes
+// are the same in every run and on every machine.
+namespace Zobrist {
+    // board size, kept in sync with Board by a static_assert in Board.cpp
+    constexpr int WIDTH = 10;
+    constexpr int HEIGHT = 20;
+    // half a row, cell x is bit x % HALF of half x / HALF
+    constexpr int HALF = WIDTH / 2;
+
+    // piece slots hashed by Simulation: active piece, hold, preview queue
+    enum Slot { ACTIVE, HELD, QUEUE };
+    constexpr int MAX_QUEUE = 8;
+    constexpr int SLOT_COUNT = QUEUE + MAX_QUEUE;
+
+    constexpr uint64_t splitmix64(uint64_t &state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct Tables {
+        // key of every subset of a half row, so a whole row costs two loads
+        std::array<std::array<std::array<uint64_t, 1 << HALF>, 2>, HEIGHT> rows;
+        std::array<std::array<uint64_t, TETROMINO_COUNT>, SLOT_COUNT> pieces;
+        // rotation and position of the active piece, x and y offset by 4
+        std::array<std::array<std::array<uint64_t, 32>, 32>, 4> placements;
+        // the held piece keeps its rotation
+        std::array<uint64_t, 4> heldRotations;
+        uint64_t holdUsed;
+    };
+
+    constexpr Tables makeTables() {
+        Tables tables = {};
+        uint64_t state = 0x7E7215ULL;
+        for (int y = 0; y < HEIGHT; ++y) {
+            for (int half = 0; half < 2; ++half) {
+                std::array<uint64_t, 1 << HALF> &subsets = tables.rows[y][half];
+                for (int bit = 0; bit < HALF; ++bit)
+                    subsets[1 << bit] = splitmix64(state);
+                for (int mask = 1; mask < (1 << HALF); ++mask) {
+                    int low = mask & -mask;
+                    subsets[mask] = subsets[low] ^ subsets[mask ^ low];
+                }
+            }
+        }
+        for (int slot = 0; slot < SLOT_COUNT; ++slot) {
+            for (int type = 0; type < TETROMINO_COUNT; ++type)
+                tables.pieces[slot][type] = splitmix64(state);
+        }
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            for (int y = 0; y < 32; ++y) {
+                for (int x = 0; x < 32; ++x)
+                    tables.placements[rotation][y][x] = splitmix64(state);
+            }
+            tables.heldRotations[rotation] = splitmix64(state);
+        }
+        tables.holdUsed = splitmix64(state);
+        return tables;
+    }
+
+    inline constexpr Tables TABLES = makeTables();
+
+    // XOR of the keys of the cells set in mask, on row y
+    inline uint64_t row(int y, uint16_t mask) {
+        return TABLES.rows[y][0][mask & ((1 << HALF) - 1)] ^ TABLES.rows[y][1][(mask >> HALF) & ((1 << HALF) - 1)];
+    }
+
+    inline uint64_t cell(int x, int y) {
+        return row(y, static_cast<uint16_t>(1u << x));
+    }
+
+    inline uint64_t piece(int slot, Piece::Tetromino type) {
+        return TABLES.pieces[slot][type];
+    }
+
+    inline uint64_t placement(int rotation, int x, int y) {
+        return TABLES.placements[rotation & 3][(y + 4) & 31][(x + 4) & 31];
+    }
+
+    inline uint64_t held(Piece::Tetromino type, int rotation) {
+        return TABLES.pieces[HELD][type] ^ TABLES.heldRotations[rotation & 3];
+    }
+
+    // hold already used for the active piece
+    inline uint64_t holdUsed() {
+        return TABLES.holdUsed;
+    }
+}
+
+#endif /* _ZOBRIST_ */
@@ -1,8 +1,30 @@
 #include "MenuSystem.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
-int main(void)
+int main(int argc, char **argv)
 {
+    // --replay <file> [--fast]: plays a recorded game back instead of the menu
+    // --audio-buffer <frames>: audio device buffer, smaller is less latency
+    const char *replayPath = nullptr;
+    bool fast = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--fast") == 0) {
+            fast = true;
+        } else if (std::strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc) {
+            AudioManager::getInstance().setBufferFrames(std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--replay <file> [--fast]] [--audio-buffer <frames>]" << std::endl;
+            return 1;
+        }
+    }
+
     MenuSystem menuSystem;
+    if (replayPath)
+        menuSystem.startReplay(replayPath, fast);
     menuSystem.run();
     return 0;
 }
@@ -0,0 +1,169 @@
+#include "Board.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <random>
+
+// Line clears: the in-place compaction of Board::clearFullLines against a
+// naive rebuild, on hand-written cases and on random boards.
+
+namespace {
+    const char TYPES[] = "IOTSZJL";
+
+    struct Row {
+        uint16_t mask;
+        char type;
+    };
+    using Grid = std::array<Row, Board::HEIGHT>;
+
+    Grid emptyGrid() {
+        Grid grid;
+        grid.fill({ 0, 0 });
+        return grid;
+    }
+
+    void fill(Board &board, const Grid &grid) {
+        for (int y = 0; y < Board::HEIGHT; ++y)
+            board.setRow(y, grid[y].mask, grid[y].type);
+    }
+
+    // what the board must look like after the clear: the rows that are not
+    // full, in the same order, pushed to the bottom
+    Grid naiveClear(const Grid &grid, uint32_t &cleared, int &count) {
+        Grid result = emptyGrid();
+        cleared = 0;
+        count = 0;
+        int write = Board::HEIGHT - 1;
+        for (int y = Board::HEIGHT - 1; y >= 0; --y) {
+            if (grid[y].mask == Board::FULL_ROW) {
+                cleared |= 1u << y;
+                count++;
+            } else {
+                result[write--] = grid[y];
+            }
+        }
+        return result;
+    }
+
+    // clears a board built from grid and compares every row, cell, the
+    // cleared mask and the hash with the naive version
+    void checkClear(const Grid &grid) {
+        Board board;
+        fill(board, grid);
+        uint32_t expectedCleared;
+        int expectedCount;
+        Grid expected = naiveClear(grid, expectedCleared, expectedCount);
+
+        CHECK_EQ(board.clearFullLines(), expectedCount);
+        CHECK_EQ(board.getLastClearedRows(), expectedCleared);
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            CHECK_EQ(board.getRow(y), expected[y].mask);
+            for (int x = 0; x < Board::WIDTH; ++x)
+                CHECK_EQ(board.getCell(x, y), (expected[y].mask >> x) & 1 ? expected[y].type : 0);
+        }
+        Board reference;
+        fill(reference, expected);
+        CHECK_EQ(board.getHash(), reference.getHash());
+    }
+
+    void testNoClear() {
+        Grid grid = emptyGrid();
+        grid[19] = { Board::FULL_ROW & ~1u, 'I' };
+        grid[18] = { 0x0F0, 'T' };
+        checkClear(grid);
+
+        Board board;
+        fill(board, grid);
+        uint32_t version = board.getCellsVersion();
+        CHECK_EQ(board.clearFullLines(), 0);
+        CHECK_EQ(board.getLastClearedRows(), 0u);
+        CHECK_EQ(board.getCellsVersion(), version);
+    }
+
+    void testAdjacentClears() {
+        // double, triple and tetris at the bottom, with leftovers above
+        for (int lines = 1; lines <= 4; ++lines) {
+            Grid grid = emptyGrid();
+            for (int i = 0; i < lines; ++i)
+                grid[19 - i] = { Board::FULL_ROW, TYPES[i] };
+            grid[19 - lines] = { 0x201, 'S' };
+            grid[18 - lines] = { 0x030, 'Z' };
+            checkClear(grid);
+
+            Board board;
+            fill(board, grid);
+            board.clearFullLines();
+            CHECK_EQ(board.getRow(19), 0x201);
+            CHECK_EQ(board.getCell(0, 19), 'S');
+            CHECK_EQ(board.getCell(9, 19), 'S');
+            CHECK_EQ(board.getRow(18), 0x030);
+            CHECK_EQ(board.getCell(4, 18), 'Z');
+            CHECK_EQ(board.getRow(17), 0);
+        }
+        // a tetris in the middle of the stack, the rows below stay put
+        Grid grid = emptyGrid();
+        grid[19] = { 0x1FE, 'J' };
+        for (int y = 15; y <= 18; ++y)
+            grid[y] = { Board::FULL_ROW, 'I' };
+        grid[14] = { 0x00F, 'L' };
+        checkClear(grid);
+    }
+
+    void testSplitClears() {
+        // rows 19 and 17 full, a partial row 18 between them
+        Grid grid = emptyGrid();
+        grid[19] = { Board::FULL_ROW, 'I' };
+        grid[18] = { 0x0F0, 'T' };
+        grid[17] = { Board::FULL_ROW, 'O' };
+        grid[16] = { 0x003, 'Z' };
+        checkClear(grid);
+
+        Board board;
+        fill(board, grid);
+        CHECK_EQ(board.clearFullLines(), 2);
+        CHECK_EQ(board.getLastClearedRows(), (1u << 19) | (1u << 17));
+        CHECK_EQ(board.getRow(19), 0x0F0);
+        CHECK_EQ(board.getCell(4, 19), 'T');
+        CHECK_EQ(board.getCell(0, 19), 0);
+        CHECK_EQ(board.getRow(18), 0x003);
+        CHECK_EQ(board.getCell(1, 18), 'Z');
+        CHECK_EQ(board.getRow(17), 0);
+
+        // full, partial, full, partial, full: three clears split twice
+        grid = emptyGrid();
+        grid[19] = { Board::FULL_ROW, 'L' };
+        grid[18] = { 0x100, 'S' };
+        grid[17] = { Board::FULL_ROW, 'J' };
+        grid[16] = { 0x001, 'T' };
+        grid[15] = { Board::FULL_ROW, 'O' };
+        grid[14] = { 0x3F0, 'I' };
+        checkClear(grid);
+
+        // the top row full too
+        grid = emptyGrid();
+        for (int y = 0; y < Board::HEIGHT; ++y)
+            grid[y] = { static_cast<uint16_t>(y % 3 == 0 ? Board::FULL_ROW : 0x155 >> (y % 2)), TYPES[y % 7] };
+        checkClear(grid);
+    }
+
+    void testRandomBoards() {
+        std::mt19937 rng(12345);
+        for (int round = 0; round < 20000; ++round) {
+            Grid grid = emptyGrid();
+            int top = static_cast<int>(rng() % Board::HEIGHT);
+            for (int y = top; y < Board::HEIGHT; ++y) {
+                // full rows often enough to get every kind of clear
+                uint16_t mask = rng() % 3 == 0 ? Board::FULL_ROW : static_cast<uint16_t>(rng() & Board::FULL_ROW);
+                grid[y] = { mask, TYPES[rng() % 7] };
+            }
+            checkClear(grid);
+        }
+    }
+}
+
+int main() {
+    testNoClear();
+    testAdjacentClears();
+    testSplitClears();
+    testRandomBoards();
+    return check::result("board_test");
+}
@@ -0,0 +1,41 @@
+#ifndef _CHECK_
+    #define _CHECK_
+#include <iostream>
+
+// Minimal assertions for the test programs: a failed check is reported
+// with its line and the program keeps going; main returns check::result().
+namespace check {
+    inline int &failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result(const char *name) {
+        if (failures() == 0)
+            std::cout << name << ": all checks passed" << std::endl;
+        else
+            std::cout << name << ": " << failures() << " check(s) failed" << std::endl;
+        return failures() == 0 ? 0 : 1;
+    }
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            check::failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        auto checkActual = (actual); \
+        auto checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " is " << +checkActual \
+                      << ", expected " << +checkExpected << std::endl; \
+            check::failures()++; \
+        } \
+    } while (0)
+
+#endif /* _CHECK_ */
@@ -0,0 +1,176 @@
+#include "FeatureKernel.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Every FeatureKernel the CPU supports against a naive cell by cell count
+// of the seven features, on hand-written boards and random batches whose
+// sizes leave the last SIMD group partly empty.
+
+namespace {
+    const FeatureKernel::Isa KERNELS[] = { FeatureKernel::SCALAR, FeatureKernel::SSE2, FeatureKernel::AVX2 };
+
+    bool filled(const Board &board, int x, int y) {
+        return (board.getRow(y) >> x) & 1;
+    }
+
+    int columnHeight(const Board &board, int x) {
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            if (filled(board, x, y))
+                return Board::HEIGHT - y;
+        }
+        return 0;
+    }
+
+    // the definitions of FeatureKernel.hpp, one cell at a time
+    BoardFeatures reference(const Board &board) {
+        BoardFeatures features = {};
+        int heights[Board::WIDTH];
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            heights[x] = columnHeight(board, x);
+            features.aggregateHeight += heights[x];
+            features.maxHeight = std::max(features.maxHeight, heights[x]);
+            for (int y = Board::HEIGHT - heights[x]; y < Board::HEIGHT; ++y) {
+                if (!filled(board, x, y))
+                    features.holes++;
+            }
+        }
+        for (int x = 0; x + 1 < Board::WIDTH; ++x)
+            features.bumpiness += std::abs(heights[x] - heights[x + 1]);
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            int left = x > 0 ? heights[x - 1] : Board::HEIGHT;
+            int right = x + 1 < Board::WIDTH ? heights[x + 1] : Board::HEIGHT;
+            features.wells += std::max(0, std::min(left, right) - heights[x]);
+        }
+        for (int y = 0; y < Board::HEIGHT; ++y) {
+            if (board.getRow(y) == 0)
+                continue;
+            bool previous = true;
+            for (int x = 0; x <= Board::WIDTH; ++x) {
+                bool cell = x < Board::WIDTH ? filled(board, x, y) : true;
+                if (cell != previous)
+                    features.rowTransitions++;
+                previous = cell;
+            }
+        }
+        for (int x = 0; x < Board::WIDTH; ++x) {
+            bool previous = false;
+            for (int y = 0; y <= Board::HEIGHT; ++y) {
+                bool cell = y < Board::HEIGHT ? filled(board, x, y) : true;
+                if (cell != previous)
+                    features.columnTransitions++;
+                previous = cell;
+            }
+        }
+        return features;
+    }
+
+    void checkFeatures(const BoardFeatures &actual, const BoardFeatures &expected) {
+        CHECK_EQ(actual.aggregateHeight, expected.aggregateHeight);
+        CHECK_EQ(actual.holes, expected.holes);
+        CHECK_EQ(actual.bumpiness, expected.bumpiness);
+        CHECK_EQ(actual.wells, expected.wells);
+        CHECK_EQ(actual.maxHeight, expected.maxHeight);
+        CHECK_EQ(actual.rowTransitions, expected.rowTransitions);
+        CHECK_EQ(actual.columnTransitions, expected.columnTransitions);
+    }
+
+    // the single board entry point and the batch of every supported kernel
+    void checkBatch(const std::vector<Board> &boards) {
+        std::vector<const Board *> pointers;
+        std::vector<BoardFeatures> expected;
+        for (const Board &board : boards) {
+            pointers.push_back(&board);
+            expected.push_back(reference(board));
+            checkFeatures(FeatureKernel::compute(board), expected.back());
+        }
+        for (FeatureKernel::Isa isa : KERNELS) {
+            if (!FeatureKernel::isSupported(isa))
+                continue;
+            std::vector<BoardFeatures> out(boards.size());
+            FeatureKernel::compute(pointers.data(), static_cast<int>(boards.size()), out.data(), isa);
+            for (size_t i = 0; i < boards.size(); ++i)
+                checkFeatures(out[i], expected[i]);
+        }
+    }
+
+    void testEmptyBoard() {
+        std::vector<Board> boards(3);
+        checkBatch(boards);
+        BoardFeatures features = FeatureKernel::compute(boards[0]);
+        CHECK_EQ(features.aggregateHeight, 0);
+        CHECK_EQ(features.wells, 0);
+        CHECK_EQ(features.rowTransitions, 0);
+        CHECK_EQ(features.columnTransitions, Board::WIDTH);
+    }
+
+    void testFullColumns() {
+        std::vector<Board> boards;
+        // a single full column, at each edge and in the middle
+        for (int x : { 0, 4, Board::WIDTH - 1 }) {
+            Board board;
+            for (int y = 0; y < Board::HEIGHT; ++y)
+                board.setRow(y, static_cast<uint16_t>(1u << x), 'I');
+            boards.push_back(board);
+        }
+        // every column full but one: a well as deep as the board
+        Board well;
+        for (int y = 0; y < Board::HEIGHT; ++y)
+            well.setRow(y, Board::FULL_ROW & ~(1u << 6), 'O');
+        boards.push_back(well);
+        // the whole board, and the whole board with a hole at the bottom
+        Board full;
+        for (int y = 0; y < Board::HEIGHT; ++y)
+            full.setRow(y, Board::FULL_ROW, 'T');
+        boards.push_back(full);
+        full.setRow(Board::HEIGHT - 1, Board::FULL_ROW & ~1u, 'T');
+        boards.push_back(full);
+        checkBatch(boards);
+
+        BoardFeatures features = FeatureKernel::compute(well);
+        CHECK_EQ(features.maxHeight, Board::HEIGHT);
+        CHECK_EQ(features.wells, Board::HEIGHT);
+        CHECK_EQ(features.bumpiness, 2 * Board::HEIGHT);
+    }
+
+    Board randomBoard(std::mt19937 &rng) {
+        Board board;
+        int top = static_cast<int>(rng() % (Board::HEIGHT + 1));
+        for (int y = top; y < Board::HEIGHT; ++y) {
+            // denser towards the floor, with full rows and holes now and then
+            uint16_t mask = static_cast<uint16_t>(rng() & Board::FULL_ROW);
+            if (y > (top + Board::HEIGHT) / 2)
+                mask |= static_cast<uint16_t>(rng() & Board::FULL_ROW);
+            if (rng() % 8 == 0)
+                mask = Board::FULL_ROW;
+            board.setRow(y, mask, 'S');
+        }
+        return board;
+    }
+
+    void testRandomBatches() {
+        std::mt19937 rng(777);
+        // around and off the 8 and 16 board groups
+        for (int count : { 1, 5, 7, 9, 15, 17, 23, 31, 33, 100 }) {
+            for (int round = 0; round < 20; ++round) {
+                std::vector<Board> boards;
+                for (int i = 0; i < count; ++i)
+                    boards.push_back(randomBoard(rng));
+                checkBatch(boards);
+            }
+        }
+    }
+}
+
+int main() {
+    for (FeatureKernel::Isa isa : KERNELS) {
+        if (!FeatureKernel::isSupported(isa))
+            std::cout << "feature_kernel_test: " << FeatureKernel::getName(isa) << " not supported, skipped" << std::endl;
+    }
+    testEmptyBoard();
+    testFullColumns();
+    testRandomBatches();
+    return check::result("feature_kernel_test");
+}
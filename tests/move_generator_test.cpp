@@ -0,0 +1,143 @@
+#include "MoveGenerator.hpp"
+#include "Simulation.hpp"
+#include "check.hpp"
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+// MoveGenerator against a plain breadth-first search over the Simulation
+// rules (Board::isValidPosition and Simulation::rotatePiece), and every
+// getPath() replayed through Simulation::step to the placement it claims.
+
+namespace {
+    using Position = std::tuple<int, int, int>;  // rotation, x, y
+
+    // every resting position reachable with left, right, soft drop and
+    // rotate, rotations reduced to the distinct ones like the generator
+    std::set<Position> reference(const Board &board, const Piece &start, int x, int y) {
+        std::set<Position> resting;
+        if (!board.isValidPosition(start, x, y))
+            return resting;
+
+        int distinct = Piece::distinctRotations(start.getTetromino());
+        struct State {
+            Piece piece;
+            int x, y;
+        };
+        std::set<Position> seen;
+        std::vector<State> queue;
+        queue.push_back({ start, x, y });
+        seen.insert(Position(start.getRotation(), x, y));
+
+        for (size_t head = 0; head < queue.size(); ++head) {
+            State state = queue[head];
+            if (!board.isValidPosition(state.piece, state.x, state.y + 1))
+                resting.insert(Position(state.piece.getRotation() % distinct, state.x, state.y));
+
+            std::vector<State> next;
+            if (board.isValidPosition(state.piece, state.x - 1, state.y))
+                next.push_back({ state.piece, state.x - 1, state.y });
+            if (board.isValidPosition(state.piece, state.x + 1, state.y))
+                next.push_back({ state.piece, state.x + 1, state.y });
+            if (board.isValidPosition(state.piece, state.x, state.y + 1))
+                next.push_back({ state.piece, state.x, state.y + 1 });
+            State rotated = state;
+            if (Simulation::rotatePiece(board, rotated.piece, rotated.x, rotated.y))
+                next.push_back(rotated);
+
+            for (const State &candidate : next) {
+                if (seen.insert(Position(candidate.piece.getRotation(), candidate.x, candidate.y)).second)
+                    queue.push_back(candidate);
+            }
+        }
+        return resting;
+    }
+
+    // a stack up to height rows high, with holes and overhangs for tucks and spins
+    Board randomBoard(std::mt19937 &rng, int height) {
+        Board board;
+        for (int y = Board::HEIGHT - height; y < Board::HEIGHT; ++y) {
+            uint16_t mask = static_cast<uint16_t>(rng() & rng() & Board::FULL_ROW);
+            if (y > Board::HEIGHT - height / 2)
+                mask |= static_cast<uint16_t>(rng() & Board::FULL_ROW);
+            // never full, clears would move the rows the path was planned on
+            mask &= static_cast<uint16_t>(~(1u << (rng() % Board::WIDTH)));
+            board.setRow(y, mask, 'I');
+        }
+        return board;
+    }
+
+    void checkPaths(MoveGenerator &generator, const Board &board, const Piece &piece,
+                    const MoveGenerator::Placement *placements, int count) {
+        Simulation simulation(1);
+        Simulation::Snapshot start = simulation.snapshot();
+        start.board = board.snapshot();
+        start.currentPiece = piece;
+        start.pieceX = Simulation::SPAWN_X;
+        start.pieceY = Simulation::SPAWN_Y;
+        start.gameOver = false;
+
+        int distinct = Piece::distinctRotations(piece.getTetromino());
+        Simulation::Action path[256];
+        for (int i = 0; i < count; ++i) {
+            int length = generator.getPath(placements[i], path, 256);
+            CHECK(length > 0);
+            if (length <= 0)
+                continue;
+            CHECK_EQ(path[length - 1], Simulation::HARD_DROP);
+
+            simulation.restore(start);
+            int events = Simulation::EVENT_NONE;
+            for (int step = 0; step < length; ++step)
+                events = simulation.step(path[step]);
+            CHECK(events & Simulation::EVENT_PLACE);
+            const Simulation::Placement &landed = simulation.getLastPlacement();
+            CHECK_EQ(landed.piece.getRotation() % distinct, placements[i].piece.getRotation());
+            CHECK_EQ(landed.x, placements[i].x);
+            CHECK_EQ(landed.y, placements[i].y);
+        }
+    }
+
+    void testAgainstReference() {
+        std::mt19937 rng(2024);
+        MoveGenerator generator;
+        MoveGenerator::Placement placements[MoveGenerator::MAX_PLACEMENTS];
+
+        for (int round = 0; round < 300; ++round) {
+            Board board = randomBoard(rng, static_cast<int>(rng() % 15));
+            for (int type = 0; type < TETROMINO_COUNT; ++type) {
+                Piece piece(static_cast<Piece::Tetromino>(type));
+                for (int rotation = rng() % 4; rotation > 0; --rotation)
+                    piece.rotate();
+
+                std::set<Position> expected = reference(board, piece, Simulation::SPAWN_X, Simulation::SPAWN_Y);
+                int count = generator.generate(board, piece, Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                               placements, MoveGenerator::MAX_PLACEMENTS);
+                std::set<Position> generated;
+                for (int i = 0; i < count; ++i)
+                    generated.insert(Position(placements[i].piece.getRotation(), placements[i].x, placements[i].y));
+
+                CHECK_EQ(count, static_cast<int>(expected.size()));
+                CHECK(generated == expected);
+                checkPaths(generator, board, piece, placements, count);
+            }
+        }
+    }
+
+    void testBlockedSpawn() {
+        Board board;
+        for (int y = 0; y < Board::HEIGHT; ++y)
+            board.setRow(y, Board::FULL_ROW & ~1u, 'O');
+        MoveGenerator generator;
+        MoveGenerator::Placement placements[MoveGenerator::MAX_PLACEMENTS];
+        CHECK_EQ(generator.generate(board, Piece(Piece::T), Simulation::SPAWN_X, Simulation::SPAWN_Y,
+                                    placements, MoveGenerator::MAX_PLACEMENTS), 0);
+    }
+}
+
+int main() {
+    testAgainstReference();
+    testBlockedSpawn();
+    return check::result("move_generator_test");
+}
@@ -0,0 +1,226 @@
+#include "MusicStream.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// MusicStream on generated WAV playlists, no audio device: the test thread
+// plays the audio callback by calling mix() itself. Every track is one
+// constant sample value, so the output tells which track is playing.
+
+namespace {
+    const int FREQUENCY = 8000;
+    const uint64_t RING_FRAMES = MUSIC_RING_SAMPLES / 2;
+    const uint64_t READ_FRAMES = MUSIC_READ_BYTES / 4;
+
+    std::string directory;
+
+    void put16(std::ofstream &out, uint16_t value) {
+        char bytes[2] = { static_cast<char>(value & 0xFF), static_cast<char>(value >> 8) };
+        out.write(bytes, 2);
+    }
+
+    void put32(std::ofstream &out, uint32_t value) {
+        put16(out, static_cast<uint16_t>(value & 0xFFFF));
+        put16(out, static_cast<uint16_t>(value >> 16));
+    }
+
+    // 16-bit stereo at FREQUENCY, every sample the same; an odd sized
+    // chunk between "fmt " and "data" like the tags some editors write
+    std::string writeTrack(const std::string &name, uint32_t frames, int16_t value) {
+        std::string path = directory + name;
+        std::ofstream out(path, std::ios::binary);
+        uint32_t dataBytes = frames * 4;
+        out.write("RIFF", 4);
+        put32(out, 4 + 24 + 12 + 8 + dataBytes);
+        out.write("WAVE", 4);
+        out.write("fmt ", 4);
+        put32(out, 16);
+        put16(out, 1);
+        put16(out, 2);
+        put32(out, FREQUENCY);
+        put32(out, FREQUENCY * 4);
+        put16(out, 4);
+        put16(out, 16);
+        out.write("LIST", 4);
+        put32(out, 3);
+        out.write("abc", 4);
+        out.write("data", 4);
+        put32(out, dataBytes);
+        for (uint32_t i = 0; i < frames * 2; ++i)
+            put16(out, static_cast<uint16_t>(value));
+        return path;
+    }
+
+    std::string writePlaylist(const std::string &name, const std::string &lines) {
+        std::string path = directory + name;
+        std::ofstream out(path);
+        out << lines;
+        return path;
+    }
+
+    bool waitFor(const std::function<bool()> &condition) {
+        for (int i = 0; i < 500; ++i) {
+            if (condition())
+                return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    // until the decoder has nothing more to do: the ring is full or it stopped
+    uint64_t waitIdle(const MusicStream &music) {
+        uint64_t decoded = music.getStats().decodedFrames;
+        for (int i = 0; i < 50; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5 * MUSIC_POLL_MS));
+            uint64_t now = music.getStats().decodedFrames;
+            if (now == decoded && now > 0)
+                break;
+            decoded = now;
+        }
+        return decoded;
+    }
+
+    // plays blocks until a frame of value comes out, returns whether it
+    // did within limit frames; silence (the decoder behind) is waited out,
+    // for 5 s at most
+    bool playUntil(MusicStream &music, int16_t value, uint64_t limit, int16_t forbidden = 0) {
+        std::vector<int16_t> block(512);
+        for (uint64_t played = 0, waits = 0; played < limit && waits < 5000;) {
+            std::fill(block.begin(), block.end(), 0);
+            music.mix(block.data(), block.size() / 2);
+            bool silent = false;
+            for (size_t i = 0; i < block.size(); i += 2) {
+                if (block[i] == 0) {
+                    silent = true;
+                    break;
+                }
+                CHECK(forbidden == 0 || block[i] != forbidden);
+                if (block[i] == value)
+                    return true;
+                played++;
+            }
+            if (silent) {
+                waits++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return false;
+    }
+
+    void testBoundedReads() {
+        std::string track = writeTrack("long.wav", 20 * FREQUENCY, 1000);
+        std::string playlist = writePlaylist("long.txt", "0 long.wav\n");
+        {
+            MusicStream music;
+            CHECK(music.open(playlist, FREQUENCY));
+
+            // nobody listening: the decoder stops once the ring is full
+            uint64_t decoded = waitIdle(music);
+            CHECK(decoded >= RING_FRAMES);
+            CHECK(decoded <= RING_FRAMES + 2 * READ_FRAMES);
+
+            // half the ring played, about as much decoded again
+            music.setPlaying(true);
+            std::vector<int16_t> out(RING_FRAMES);
+            music.mix(out.data(), out.size() / 2);
+            CHECK_EQ(out.front(), 1000);
+            CHECK_EQ(out.back(), 1000);
+            decoded = waitIdle(music);
+            CHECK(decoded >= RING_FRAMES + RING_FRAMES / 2);
+            CHECK(decoded <= RING_FRAMES + RING_FRAMES / 2 + 2 * READ_FRAMES);
+
+            MusicStream::Stats stats = music.getStats();
+            CHECK_EQ(stats.underruns, 0u);
+            CHECK_EQ(stats.tracksStarted, 1u);
+        }
+        std::remove(track.c_str());
+        std::remove(playlist.c_str());
+    }
+
+    void testLevelSwitch() {
+        // short tracks, a switch never waits long for the end of one
+        std::string low = writeTrack("low.wav", 1000, 1000);
+        std::string mid = writeTrack("mid.wav", 700, -2000);
+        std::string high = writeTrack("high.wav", 1300, 3000);
+        std::string playlist = writePlaylist("levels.txt", "10 high.wav\n# menu and first levels\n0 low.wav\n\n5 mid.wav\n");
+        {
+            MusicStream music;
+            CHECK(music.open(playlist, FREQUENCY));
+            music.setPlaying(true);
+            // whatever is in the ring plays first, then the end of a track
+            uint64_t limit = 2 * RING_FRAMES;
+
+            CHECK(playUntil(music, 1000, limit, -2000));
+            music.setLevel(7);
+            CHECK(playUntil(music, -2000, limit, 3000));
+            music.setLevel(12);
+            CHECK(playUntil(music, 3000, limit));
+            music.setLevel(3);
+            CHECK(playUntil(music, 1000, limit));
+            CHECK(music.getStats().tracksStarted >= 4u);
+        }
+        for (const std::string &path : { low, mid, high, playlist })
+            std::remove(path.c_str());
+    }
+
+    void testUnderruns() {
+        std::string track = writeTrack("short.wav", 500, 1000);
+        std::string playlist = writePlaylist("short.txt", "0 short.wav\n");
+        MusicStream music;
+        CHECK(music.open(playlist, FREQUENCY));
+
+        // the track goes away once it started: the decoder cannot
+        // start it again and stops, from then on the callback outruns it
+        CHECK(waitFor([&music]() { return music.getStats().tracksStarted > 0; }));
+        std::remove(track.c_str());
+        std::cerr << "music_stream_test: a failure to open short.wav is expected" << std::endl;
+        waitIdle(music);
+        CHECK_EQ(music.getStats().underruns, 0u);
+
+        // more than the ring holds, in one callback and then in a second
+        // one once the decoder is gone for good
+        std::vector<int16_t> out(4 * RING_FRAMES);
+        music.mix(out.data(), out.size() / 2);
+        CHECK_EQ(music.getStats().underruns, 0u);
+        music.setPlaying(true);
+        music.mix(out.data(), out.size() / 2);
+        MusicStream::Stats stats = music.getStats();
+        CHECK_EQ(stats.underruns, 1u);
+        CHECK(stats.missingFrames > 0);
+        waitIdle(music);
+        music.mix(out.data(), out.size() / 2);
+        uint64_t missing = stats.missingFrames;
+        stats = music.getStats();
+        CHECK_EQ(stats.underruns, 2u);
+        CHECK(stats.missingFrames >= missing + RING_FRAMES);
+        music.mix(out.data(), 256);
+        missing = stats.missingFrames;
+        stats = music.getStats();
+        CHECK_EQ(stats.underruns, 3u);
+        CHECK_EQ(stats.missingFrames, missing + 256);
+        music.close();
+        std::remove(playlist.c_str());
+    }
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    // the files go next to the test program
+    directory = argv[0];
+    directory = directory.substr(0, directory.find_last_of('/') + 1);
+    if (SDL_Init(0) != 0) {
+        std::cerr << "SDL_Init failed: " << SDL_GetError() << std::endl;
+        return 1;
+    }
+    testBoundedReads();
+    testLevelSwitch();
+    testUnderruns();
+    SDL_Quit();
+    return check::result("music_stream_test");
+}
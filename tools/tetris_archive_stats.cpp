@@ -0,0 +1,130 @@
+#include "SessionArchive.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // sessions per parallelFor index, enough to amortise the task call
+    const size_t CHUNK = 1024;
+
+    // per-worker counts, padded so workers never share a cache line
+    struct alignas(64) WorkerCounts {
+        std::array<long long, TETROMINO_COUNT> pieces = {};
+        long long placements = 0;
+    };
+
+    void usage(const char *name) {
+        std::cerr << "Usage: " << name << " [options] <archive>\n"
+                  << "  -j <threads>     worker threads, 0 = all cores (default 0)\n"
+                  << "  -t <rate>        ticks per second the games ran at (default 60)\n";
+    }
+
+    // mean and a few percentiles, sorts values
+    void printDistribution(const char *label, std::vector<double> &values) {
+        std::cout << std::left << std::setw(14) << label << std::right;
+        if (values.empty()) {
+            std::cout << "-\n";
+            return;
+        }
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value : values)
+            sum += value;
+        auto percentile = [&values](double p) {
+            return values[static_cast<size_t>(p * (values.size() - 1))];
+        };
+        std::cout << "mean " << sum / values.size()
+                  << ", min " << values.front()
+                  << ", p10 " << percentile(0.10)
+                  << ", p50 " << percentile(0.50)
+                  << ", p90 " << percentile(0.90)
+                  << ", p99 " << percentile(0.99)
+                  << ", max " << values.back() << "\n";
+    }
+}
+
+// Scans a session archive in parallel straight from the mapping (only the
+// pages being read are in memory) and prints score, lines, speed and
+// piece usage over every game in it.
+int main(int argc, char **argv) {
+    int threads = 0;
+    double tickRate = 60.0;
+
+    int i = 1;
+    for (; i + 1 < argc && argv[i][0] == '-' && std::strlen(argv[i]) == 2; i += 2) {
+        const char *value = argv[i + 1];
+        switch (argv[i][1]) {
+            case 'j': threads = std::atoi(value); break;
+            case 't': tickRate = std::atof(value); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (i + 1 != argc || tickRate <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    SessionArchive archive;
+    if (!archive.open(argv[i]))
+        return 1;
+
+    size_t sessions = archive.size();
+    std::vector<double> scores(sessions), lines(sessions), levels(sessions), pieces(sessions), speeds(sessions);
+    ThreadPool pool(threads);
+    std::vector<WorkerCounts> counts(pool.size());
+
+    auto start = std::chrono::steady_clock::now();
+    int chunks = static_cast<int>((sessions + CHUNK - 1) / CHUNK);
+    pool.parallelFor(chunks, [&](int chunk, int worker) {
+        WorkerCounts &mine = counts[worker];
+        size_t end = std::min(sessions, (chunk + 1) * CHUNK);
+        for (size_t s = chunk * CHUNK; s < end; ++s) {
+            const SessionArchive::Entry &entry = archive.getEntry(s);
+            scores[s] = entry.score;
+            lines[s] = entry.lines;
+            levels[s] = entry.level;
+            pieces[s] = entry.pieces;
+            speeds[s] = entry.ticks > 0 ? entry.pieces * tickRate / entry.ticks : 0.0;
+
+            const uint16_t *placements = archive.getPlacements(s);
+            for (int p = 0; p < entry.pieces; ++p)
+                mine.pieces[SessionArchive::decode(placements[p]).piece.getTetromino()]++;
+            mine.placements += entry.pieces;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    WorkerCounts total;
+    for (const WorkerCounts &worker : counts) {
+        for (int t = 0; t < TETROMINO_COUNT; ++t)
+            total.pieces[t] += worker.pieces[t];
+        total.placements += worker.placements;
+    }
+
+    std::cout << "sessions:     " << sessions << " (" << pool.size() << " threads)\n"
+              << "placements:   " << total.placements << "\n";
+    printDistribution("score:", scores);
+    printDistribution("lines:", lines);
+    printDistribution("level:", levels);
+    printDistribution("pieces:", pieces);
+    printDistribution("pieces/sec:", speeds);
+
+    const char names[TETROMINO_COUNT] = { 'I', 'O', 'T', 'S', 'Z', 'J', 'L' };
+    std::cout << "piece usage: ";
+    for (int t = 0; t < TETROMINO_COUNT; ++t) {
+        double share = total.placements ? 100.0 * total.pieces[t] / total.placements : 0.0;
+        std::cout << " " << names[t] << " " << std::fixed << std::setprecision(1) << share << "%";
+    }
+    std::cout << std::defaultfloat << "\n"
+              << "scan time:    " << seconds << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "Replay.hpp"
+#include <chrono>
+#include <iostream>
+
+// Plays a replay back headless, as fast as possible, and prints how the
+// game ended: the same numbers the game showed when it was recorded.
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <replay file>" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Replay> replay(new Replay());
+    if (!Replay::load(argv[1], *replay))
+        return 1;
+    size_t inputs = replay->inputs.size();
+    bool complete = replay->complete;
+
+    ReplayPlayer player(std::move(replay));
+    Simulation simulation = player.createSimulation();
+    auto start = std::chrono::steady_clock::now();
+    while (!player.isFinished(simulation))
+        player.advance(simulation);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "seed:         " << player.getReplay().seed << "\n"
+              << "inputs:       " << inputs << (complete ? "" : " (recording cut short)") << "\n"
+              << "ticks:        " << simulation.getTickCount() << "\n"
+              << "pieces:       " << simulation.getPieceCount() << "\n"
+              << "lines:        " << simulation.getTotalLines() << "\n"
+              << "score:        " << simulation.getBoard().getScore() << "\n"
+              << "game over:    " << (simulation.isGameOver() ? "yes" : "no") << "\n"
+              << "time:         " << seconds << " s" << std::endl;
+    return 0;
+}
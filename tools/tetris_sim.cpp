@@ -0,0 +1,133 @@
+#include "AutoPlayer.hpp"
+#include "SelfPlay.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    // Plays through the beam search player of the worker thread it is
+    // created on: each worker builds its planner (search threads and score
+    // cache) once for the whole batch instead of once per game.
+    class WorkerBeamPolicy : public MovePolicy {
+        public:
+            explicit WorkerBeamPolicy(int beamThreads) : player(workerPlayer(beamThreads)) {
+                player.reset();
+            }
+            Simulation::Action chooseAction(const Simulation &simulation) override {
+                return player.chooseAction(simulation);
+            }
+
+        private:
+            AutoPlayer &player;
+
+            static AutoPlayer &workerPlayer(int beamThreads) {
+                thread_local std::unique_ptr<AutoPlayer> mine;
+                if (!mine) {
+                    // no deadline so a batch replays the same on any machine
+                    BeamSearch::Settings settings;
+                    settings.deadlineMicros = 0;
+                    settings.threads = beamThreads;
+                    std::unique_ptr<BeamSearch> planner(new BeamSearch(Evaluator(), settings));
+                    mine.reset(new AutoPlayer(std::move(planner)));
+                }
+                return *mine;
+            }
+    };
+
+    void usage(const char *name) {
+        std::cerr << "Usage: " << name << " [options]\n"
+                  << "  -n <games>       number of games to play (default 1000)\n"
+                  << "  -j <threads>     worker threads, 0 = all cores (default 0)\n"
+                  << "  -s <seed>        batch seed (default 1)\n"
+                  << "  -m <pieces>      stop each game after this many pieces, 0 = no limit (default 0)\n"
+                  << "  -p <policy>      move policy: random, ai or beam (default random)\n"
+                  << "  -b <threads>     beam search threads per game, 0 = all cores (default 1)\n"
+                  << "  -r <randomizer>  piece randomizer: random or bag (default random)\n"
+                  << "  -a <archive>     append every game to this session archive\n";
+    }
+
+    PolicyFactory findPolicy(const std::string &name, int beamThreads) {
+        if (name == "random") {
+            return [](uint64_t seed) {
+                return std::unique_ptr<MovePolicy>(new RandomPlacementPolicy(seed));
+            };
+        }
+        if (name == "ai") {
+            return [](uint64_t) {
+                return std::unique_ptr<MovePolicy>(new AutoPlayer());
+            };
+        }
+        if (name == "beam") {
+            return [beamThreads](uint64_t) {
+                return std::unique_ptr<MovePolicy>(new WorkerBeamPolicy(beamThreads));
+            };
+        }
+        return PolicyFactory();
+    }
+}
+
+int main(int argc, char **argv) {
+    int games = 1000;
+    int threads = 0;
+    uint64_t seed = 1;
+    int maxPieces = 0;
+    int beamThreads = 1;
+    std::string policyName = "random";
+    std::string randomizerName = "random";
+    std::string archivePath;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc || arg[0] != '-' || std::strlen(arg) != 2) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        switch (arg[1]) {
+            case 'n': games = std::atoi(value); break;
+            case 'j': threads = std::atoi(value); break;
+            case 's': seed = std::strtoull(value, nullptr, 10); break;
+            case 'm': maxPieces = std::atoi(value); break;
+            case 'p': policyName = value; break;
+            case 'b': beamThreads = std::atoi(value); break;
+            case 'r': randomizerName = value; break;
+            case 'a': archivePath = value; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    PolicyFactory policy = findPolicy(policyName, beamThreads);
+    if (!policy) {
+        std::cerr << "Unknown policy: " << policyName << std::endl;
+        return 1;
+    }
+
+    if (randomizerName != "random" && randomizerName != "bag") {
+        std::cerr << "Unknown randomizer: " << randomizerName << std::endl;
+        return 1;
+    }
+
+    SelfPlayRunner runner(threads);
+    runner.setRandomizerMode(randomizerName == "bag" ? Randomizer::BAG_7 : Randomizer::PURE_RANDOM);
+    std::unique_ptr<SessionArchiveWriter> archive;
+    if (!archivePath.empty()) {
+        archive.reset(new SessionArchiveWriter(archivePath));
+        if (!archive->isOpen())
+            return 1;
+        runner.setArchive(archive.get());
+    }
+    BatchStats stats = runner.run(games, seed, policy, maxPieces);
+
+    std::cout << "games:        " << stats.games << " (" << runner.threadCount() << " threads, policy "
+              << policyName << ", " << randomizerName << " randomizer, seed " << seed << ")\n"
+              << "pieces:       " << stats.totalPieces << "\n"
+              << "lines:        " << stats.totalLines << "\n"
+              << "score:        " << stats.totalScore << " total, " << stats.bestScore << " best, "
+              << (stats.games ? static_cast<double>(stats.totalScore) / stats.games : 0.0) << " mean\n"
+              << "time:         " << stats.seconds << " s\n"
+              << "pieces/sec:   " << static_cast<long long>(stats.piecesPerSecond()) << std::endl;
+    return 0;
+}